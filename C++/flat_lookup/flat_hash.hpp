@@ -0,0 +1,612 @@
+#ifndef FLAT_HASH_HPP
+#define FLAT_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Open addressing hash set and map in the style of Abseil's Swiss tables:
+//
+//   flat_hash_set<char> exclude{' ', '_', '-'};
+//   flat_hash_map<char, int> counter;
+//   if (!exclude.contains(c)) ++counter[c];
+//
+// The elements sit in one flat array, next to an array of one control byte per slot: empty, deleted,
+// or the low 7 bits of the hash of a full slot. A lookup compares the control bytes of a group of 16
+// slots to those 7 bits with one SSE2 compare, and only compares keys for the slots that match, so
+// it usually touches one line of control bytes and one slot. The table grows at 7/8 full.
+//
+// Inserting or erasing moves no other element but growing does, which invalidates iterators and
+// references like std::unordered_map::rehash() would.
+namespace lookup
+{
+
+namespace detail
+{
+
+// Slots of a group, compared at once.
+constexpr std::size_t GROUP = 16;
+
+// Control bytes, a full slot holds 7 bits of the hash in [0, 127].
+constexpr std::int8_t EMPTY = -128;
+constexpr std::int8_t DELETED = -2;
+
+// Bit i set for every slot i of the group starting at ctrl whose control byte is h2, or that is
+// empty, or that is empty or deleted.
+struct group
+{
+#if defined(__SSE2__)
+    __m128i ctrl;
+
+    explicit group(const std::int8_t* p) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) {}
+
+    unsigned match(std::int8_t h2) const
+    {
+        return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2))));
+    }
+
+    unsigned match_empty() const
+    {
+        return match(EMPTY);
+    }
+
+    unsigned match_free() const
+    {
+        return static_cast<unsigned>(_mm_movemask_epi8(ctrl)); // 只有 EMPTY 和 DELETED 的最高位是 1
+    }
+#else
+    const std::int8_t* ctrl;
+
+    explicit group(const std::int8_t* p) : ctrl(p) {}
+
+    unsigned match(std::int8_t h2) const
+    {
+        unsigned mask = 0;
+        for (std::size_t i = 0; i < GROUP; i++)
+        {
+            mask |= static_cast<unsigned>(ctrl[i] == h2) << i;
+        }
+        return mask;
+    }
+
+    unsigned match_empty() const
+    {
+        return match(EMPTY);
+    }
+
+    unsigned match_free() const
+    {
+        unsigned mask = 0;
+        for (std::size_t i = 0; i < GROUP; i++)
+        {
+            mask |= static_cast<unsigned>(ctrl[i] < 0) << i;
+        }
+        return mask;
+    }
+#endif
+};
+
+// std::hash of integers is the identity in libstdc++, mix it so both the low bits that pick the
+// group and the 7 bits of the control byte depend on the whole key.
+inline std::uint64_t mix(std::uint64_t h)
+{
+    h *= 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 32);
+}
+
+// Table of Slot, found by the key KeyOf::get() gives. flat_hash_set and flat_hash_map are it with
+// the element itself or the first of a pair as key.
+template <typename Key, typename Slot, typename KeyOf, typename Hash, typename KeyEqual>
+class flat_table
+{
+public:
+    using key_type = Key;
+    using value_type = Slot;
+    using size_type = std::size_t;
+
+    template <bool Const>
+    class basic_iterator
+    {
+        friend class flat_table;
+
+        using table_ctrl = const std::int8_t*;
+        using table_slot = std::conditional_t<Const, const Slot*, Slot*>;
+
+        table_ctrl ctrl_ = nullptr;
+        table_slot slot_ = nullptr;
+        table_ctrl end_ = nullptr;
+
+        basic_iterator(table_ctrl ctrl, table_slot slot, table_ctrl end) : ctrl_(ctrl), slot_(slot), end_(end)
+        {
+            skip();
+        }
+
+        // 跳过空的和删除的槽位
+        void skip()
+        {
+            while (ctrl_ != end_ && *ctrl_ < 0)
+            {
+                ++ctrl_;
+                ++slot_;
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Slot;
+        using difference_type = std::ptrdiff_t;
+        using pointer = table_slot;
+        using reference = std::conditional_t<Const, const Slot&, Slot&>;
+
+        basic_iterator() = default;
+
+        operator basic_iterator<true>() const
+        {
+            basic_iterator<true> it;
+            it.ctrl_ = ctrl_;
+            it.slot_ = slot_;
+            it.end_ = end_;
+            return it;
+        }
+
+        reference operator*() const
+        {
+            return *slot_;
+        }
+
+        pointer operator->() const
+        {
+            return slot_;
+        }
+
+        basic_iterator& operator++()
+        {
+            ++ctrl_;
+            ++slot_;
+            skip();
+            return *this;
+        }
+
+        basic_iterator operator++(int)
+        {
+            basic_iterator it = *this;
+            ++*this;
+            return it;
+        }
+
+        bool operator==(const basic_iterator& that) const
+        {
+            return ctrl_ == that.ctrl_;
+        }
+
+        friend class basic_iterator<!Const>;
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    flat_table() = default;
+
+    flat_table(const flat_table& that) : hash_(that.hash_), equal_(that.equal_)
+    {
+        reserve(that.size_);
+        for (const Slot& slot : that)
+        {
+            emplace_copy(slot);
+        }
+    }
+
+    flat_table(flat_table&& that) noexcept
+    {
+        swap(that);
+    }
+
+    flat_table& operator=(flat_table that) noexcept
+    {
+        swap(that);
+        return *this;
+    }
+
+    ~flat_table()
+    {
+        destroy();
+    }
+
+    void swap(flat_table& that) noexcept
+    {
+        std::swap(memory_, that.memory_);
+        std::swap(ctrl_, that.ctrl_);
+        std::swap(slots_, that.slots_);
+        std::swap(capacity_, that.capacity_);
+        std::swap(size_, that.size_);
+        std::swap(growth_left_, that.growth_left_);
+        std::swap(hash_, that.hash_);
+        std::swap(equal_, that.equal_);
+    }
+
+    iterator begin()
+    {
+        return iterator(ctrl_, slots_, ctrl_ + capacity_);
+    }
+
+    iterator end()
+    {
+        return iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_);
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(ctrl_, slots_, ctrl_ + capacity_);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_);
+    }
+
+    size_type size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    size_type capacity() const
+    {
+        return capacity_;
+    }
+
+    void clear()
+    {
+        destroy();
+        memory_ = nullptr;
+        ctrl_ = nullptr;
+        slots_ = nullptr;
+        capacity_ = size_ = growth_left_ = 0;
+    }
+
+    // Room for n elements without growing.
+    void reserve(size_type n)
+    {
+        size_type capacity = GROUP;
+        while (capacity / 8 * 7 < n)
+        {
+            capacity *= 2;
+        }
+        if (capacity > capacity_)
+        {
+            rehash(capacity);
+        }
+    }
+
+    iterator find(const Key& key)
+    {
+        size_type i = find_index(key);
+        return i == capacity_ ? end() : iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_);
+    }
+
+    const_iterator find(const Key& key) const
+    {
+        size_type i = find_index(key);
+        return i == capacity_ ? end() : const_iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_);
+    }
+
+    bool contains(const Key& key) const
+    {
+        return find_index(key) != capacity_;
+    }
+
+    size_type count(const Key& key) const
+    {
+        return contains(key);
+    }
+
+    bool erase(const Key& key)
+    {
+        size_type i = find_index(key);
+        if (i == capacity_)
+        {
+            return false;
+        }
+        erase_at(i);
+        return true;
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        size_type i = pos.ctrl_ - ctrl_;
+        erase_at(i);
+        return iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_);
+    }
+
+protected:
+    // Position of key, or of the slot it was constructed in with args when absent.
+    template <typename... Args>
+    std::pair<iterator, bool> find_or_emplace(const Key& key, Args&&... args)
+    {
+        std::uint64_t h = mix(hash_(key));
+        if (capacity_ > 0)
+        {
+            size_type i = find_index(key, h);
+            if (i != capacity_)
+            {
+                return {iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_), false};
+            }
+        }
+        size_type i = emplace_new(h, std::forward<Args>(args)...);
+        return {iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_), true};
+    }
+
+private:
+    void* memory_ = nullptr; // control bytes, then the slots
+    std::int8_t* ctrl_ = nullptr;
+    Slot* slots_ = nullptr;
+    size_type capacity_ = 0; // power of 2, at least GROUP, or 0
+    size_type size_ = 0;
+    size_type growth_left_ = 0; // empty slots that may still be filled before growing
+    [[no_unique_address]] Hash hash_;
+    [[no_unique_address]] KeyEqual equal_;
+
+    static constexpr std::size_t ALIGN = alignof(Slot) > GROUP ? alignof(Slot) : GROUP;
+
+    // The first GROUP - 1 control bytes are repeated after the last, so a group read anywhere in the
+    // table wraps around without a branch.
+    void set_ctrl(size_type i, std::int8_t c)
+    {
+        ctrl_[i] = c;
+        ctrl_[((i - (GROUP - 1)) & (capacity_ - 1)) + (GROUP - 1)] = c;
+    }
+
+    static size_type ctrl_bytes(size_type capacity)
+    {
+        return (capacity + GROUP + ALIGN - 1) / ALIGN * ALIGN;
+    }
+
+    size_type find_index(const Key& key) const
+    {
+        return capacity_ == 0 ? 0 : find_index(key, mix(hash_(key)));
+    }
+
+    // Quadratic probing over groups: the group starts move by GROUP, 2 * GROUP, 3 * GROUP, ... slots,
+    // which visits every group of a power of 2 table.
+    size_type find_index(const Key& key, std::uint64_t h) const
+    {
+        std::int8_t h2 = static_cast<std::int8_t>(h & 0x7F);
+        size_type mask = capacity_ - 1;
+        size_type pos = (h >> 7) & mask;
+        for (size_type step = GROUP;; step += GROUP)
+        {
+            group g(ctrl_ + pos);
+            for (unsigned match = g.match(h2); match; match &= match - 1)
+            {
+                size_type i = (pos + __builtin_ctz(match)) & mask;
+                if (equal_(KeyOf::get(slots_[i]), key)) [[likely]]
+                {
+                    return i;
+                }
+            }
+            if (g.match_empty()) [[likely]]
+            {
+                return capacity_;
+            }
+            pos = (pos + step) & mask;
+        }
+    }
+
+    // First empty or deleted slot on the probe sequence of h.
+    size_type find_free(std::uint64_t h) const
+    {
+        size_type mask = capacity_ - 1;
+        size_type pos = (h >> 7) & mask;
+        for (size_type step = GROUP;; step += GROUP)
+        {
+            if (unsigned free = group(ctrl_ + pos).match_free())
+            {
+                return (pos + __builtin_ctz(free)) & mask;
+            }
+            pos = (pos + step) & mask;
+        }
+    }
+
+    // A slot can become empty again unless it lies in a run of GROUP slots none of them empty: a probe
+    // may have gone past that run, and then has to go past it again.
+    void erase_at(size_type i)
+    {
+        slots_[i].~Slot();
+        unsigned after = group(ctrl_ + i).match_empty();
+        unsigned before = group(ctrl_ + ((i - GROUP) & (capacity_ - 1))).match_empty();
+        bool was_never_full =
+            after && before && __builtin_ctz(after) + (__builtin_clz(before) - 16) < static_cast<int>(GROUP);
+        set_ctrl(i, was_never_full ? EMPTY : DELETED);
+        growth_left_ += was_never_full;
+        size_--;
+    }
+
+    // Construct a slot for a key known to be absent.
+    template <typename... Args>
+    size_type emplace_new(std::uint64_t h, Args&&... args)
+    {
+        if (growth_left_ == 0)
+        {
+            // 删除标记占了太多位置时原地重建，否则容量翻倍
+            rehash(capacity_ == 0 ? GROUP : size_ * 16 <= capacity_ * 7 ? capacity_ : capacity_ * 2);
+        }
+        size_type i = find_free(h);
+        ::new (static_cast<void*>(slots_ + i)) Slot(std::forward<Args>(args)...);
+        growth_left_ -= ctrl_[i] == EMPTY;
+        set_ctrl(i, static_cast<std::int8_t>(h & 0x7F));
+        size_++;
+        return i;
+    }
+
+    size_type emplace_copy(const Slot& slot)
+    {
+        return emplace_new(mix(hash_(KeyOf::get(slot))), slot);
+    }
+
+    void rehash(size_type capacity)
+    {
+        void* old_memory = memory_;
+        std::int8_t* old_ctrl = ctrl_;
+        Slot* old_slots = slots_;
+        size_type old_capacity = capacity_;
+
+        memory_ = ::operator new(ctrl_bytes(capacity) + capacity * sizeof(Slot), std::align_val_t(ALIGN));
+        ctrl_ = static_cast<std::int8_t*>(memory_);
+        slots_ = reinterpret_cast<Slot*>(ctrl_ + ctrl_bytes(capacity));
+        capacity_ = capacity;
+        growth_left_ = capacity / 8 * 7 - size_;
+        std::memset(ctrl_, EMPTY, capacity + GROUP);
+
+        for (size_type i = 0; i < old_capacity; i++)
+        {
+            if (old_ctrl[i] >= 0)
+            {
+                std::uint64_t h = mix(hash_(KeyOf::get(old_slots[i])));
+                size_type j = find_free(h);
+                ::new (static_cast<void*>(slots_ + j)) Slot(std::move(old_slots[i]));
+                old_slots[i].~Slot();
+                set_ctrl(j, static_cast<std::int8_t>(h & 0x7F));
+            }
+        }
+        if (old_memory)
+        {
+            ::operator delete(old_memory, std::align_val_t(ALIGN));
+        }
+    }
+
+    void destroy()
+    {
+        for (size_type i = 0; i < capacity_; i++)
+        {
+            if (ctrl_[i] >= 0)
+            {
+                slots_[i].~Slot();
+            }
+        }
+        if (memory_)
+        {
+            ::operator delete(memory_, std::align_val_t(ALIGN));
+        }
+    }
+};
+
+struct identity_key
+{
+    template <typename T>
+    static const T& get(const T& value)
+    {
+        return value;
+    }
+};
+
+struct first_key
+{
+    template <typename Pair>
+    static const auto& get(const Pair& pair)
+    {
+        return pair.first;
+    }
+};
+
+} // namespace detail
+
+template <typename Key, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class flat_hash_set : public detail::flat_table<Key, Key, detail::identity_key, Hash, KeyEqual>
+{
+    using base = detail::flat_table<Key, Key, detail::identity_key, Hash, KeyEqual>;
+
+public:
+    flat_hash_set() = default;
+
+    flat_hash_set(std::initializer_list<Key> keys)
+    {
+        base::reserve(keys.size());
+        for (const Key& key : keys)
+        {
+            insert(key);
+        }
+    }
+
+    std::pair<typename base::iterator, bool> insert(const Key& key)
+    {
+        return base::find_or_emplace(key, key);
+    }
+};
+
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class flat_hash_map : public detail::flat_table<Key, std::pair<const Key, Value>, detail::first_key, Hash, KeyEqual>
+{
+    using base = detail::flat_table<Key, std::pair<const Key, Value>, detail::first_key, Hash, KeyEqual>;
+
+public:
+    using mapped_type = Value;
+
+    flat_hash_map() = default;
+
+    flat_hash_map(std::initializer_list<std::pair<const Key, Value>> pairs)
+    {
+        base::reserve(pairs.size());
+        for (const auto& pair : pairs)
+        {
+            insert(pair);
+        }
+    }
+
+    std::pair<typename base::iterator, bool> insert(const std::pair<const Key, Value>& pair)
+    {
+        return base::find_or_emplace(pair.first, pair);
+    }
+
+    // Value constructed from args only when key is absent, as std::map::try_emplace does.
+    template <typename... Args>
+    std::pair<typename base::iterator, bool> try_emplace(const Key& key, Args&&... args)
+    {
+        return base::find_or_emplace(key, std::piecewise_construct, std::forward_as_tuple(key),
+                                     std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    Value& operator[](const Key& key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    Value& at(const Key& key)
+    {
+        auto it = base::find(key);
+        if (it == base::end())
+        {
+            throw std::out_of_range("flat_hash_map::at");
+        }
+        return it->second;
+    }
+
+    const Value& at(const Key& key) const
+    {
+        auto it = base::find(key);
+        if (it == base::end())
+        {
+            throw std::out_of_range("flat_hash_map::at");
+        }
+        return it->second;
+    }
+};
+
+} // namespace lookup
+
+#endif // FLAT_HASH_HPP
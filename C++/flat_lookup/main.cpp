@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "flat_hash.hpp"
+#include "simd_find.hpp"
+
+using namespace lookup;
+
+constexpr int TRIALS = 5;
+
+// Best time in ns per query of `run`, which returns a checksum compared across the rows of a table.
+template <typename Run>
+void bench(const char* name, long queries, long expect, Run run)
+{
+    double best = 1e300;
+    bool ok = true;
+    for (int i = 0; i < TRIALS; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        long sum = run();
+        auto stop = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(stop - start).count() / queries);
+        ok = ok && sum == expect;
+    }
+    std::cout << "  " << name << ":\t" << best << " ns\t" << (ok ? "ok" : "WRONG") << std::endl;
+}
+
+// myfind() of study_cpp/3. Advanced.cpp against std::find and simd_find on arrays of n ints and n
+// bytes, looking for values that are present in about half the queries.
+void bench_find(std::mt19937& gen, int n)
+{
+    constexpr int QUERIES = 1000;
+    std::vector<int> ints(n);
+    std::vector<char> bytes(n);
+    for (int i = 0; i < n; i++)
+    {
+        ints[i] = static_cast<int>(gen() % (2u * n));
+        bytes[i] = static_cast<char>('a' + gen() % 26);
+    }
+    std::vector<int> keys(QUERIES);
+    for (auto& key : keys)
+    {
+        key = static_cast<int>(gen() % (2u * n));
+    }
+    // 字节只有 26 种，大多能找到，用不在里面的字母 'z' + 1 补上找不到的情况
+    std::vector<char> chars(QUERIES);
+    for (int q = 0; q < QUERIES; q++)
+    {
+        chars[q] = q % 2 ? static_cast<char>('a' + gen() % 26) : '{';
+    }
+
+    auto position = [&](auto find, const auto& v, const auto& xs) {
+        long sum = 0;
+        for (auto x : xs)
+        {
+            sum += find(v, x) - v.data();
+        }
+        return sum;
+    };
+    auto std_find = [](const auto& v, auto x) { return std::find(v.data(), v.data() + v.size(), x); };
+    auto my_find = [](const auto& v, auto x) {
+        auto first = v.data(), last = v.data() + v.size();
+        for (; first != last; ++first)
+        {
+            if (*first == x)
+            {
+                return first;
+            }
+        }
+        return last;
+    };
+    auto fast_find = [](const auto& v, auto x) { return simd_find(v.data(), v.data() + v.size(), x); };
+
+    long expect = position(std_find, ints, keys);
+    std::cout << "find, " << n << " ints:" << std::endl;
+    bench("myfind", QUERIES, expect, [&] { return position(my_find, ints, keys); });
+    bench("std::find", QUERIES, expect, [&] { return position(std_find, ints, keys); });
+    bench("simd_find", QUERIES, expect, [&] { return position(fast_find, ints, keys); });
+
+    expect = position(std_find, bytes, chars);
+    auto mem_find = [](const auto& v, char x) {
+        const void* p = std::memchr(v.data(), x, v.size());
+        return p ? static_cast<const char*>(p) : v.data() + v.size();
+    };
+    std::cout << "find, " << n << " bytes:" << std::endl;
+    bench("myfind", QUERIES, expect, [&] { return position(my_find, bytes, chars); });
+    bench("std::find", QUERIES, expect, [&] { return position(std_find, bytes, chars); });
+    bench("memchr", QUERIES, expect, [&] { return position(mem_find, bytes, chars); });
+    bench("simd_find", QUERIES, expect, [&] { return position(fast_find, bytes, chars); });
+
+    auto total = [&](auto count, const auto& v, const auto& xs) {
+        long sum = 0;
+        for (int q = 0; q < 100; q++)
+        {
+            sum += count(v, xs[q]);
+        }
+        return sum;
+    };
+    auto std_count = [](const auto& v, auto x) { return std::count(v.begin(), v.end(), x); };
+    auto fast_count = [](const auto& v, auto x) { return static_cast<long>(simd_count(v, x)); };
+    std::cout << "count, " << n << " ints / bytes:" << std::endl;
+    bench("std::count ints", 100, total(std_count, ints, keys), [&] { return total(std_count, ints, keys); });
+    bench("simd_count ints", 100, total(std_count, ints, keys), [&] { return total(fast_count, ints, keys); });
+    bench("std::count bytes", 100, total(std_count, bytes, chars), [&] { return total(std_count, bytes, chars); });
+    bench("simd_count bytes", 100, total(std_count, bytes, chars), [&] { return total(fast_count, bytes, chars); });
+}
+
+// The character counter of test_12() in study_cpp/2. STL.cpp on a long text: a set of excluded
+// characters and a map of counts, with std::set and std::map, their unordered versions, flat_hash_*
+// and a simd_find over the excluded characters.
+void bench_counter(std::mt19937& gen)
+{
+    const char excluded[] = " _-+=<>!@#$%^*()";
+    std::string text(1'000'000, ' ');
+    for (auto& c : text)
+    {
+        c = static_cast<char>(' ' + gen() % 95);
+    }
+
+    auto count = [&](auto& exclude, auto& counter, auto is_excluded) {
+        for (char c : text)
+        {
+            if (!is_excluded(exclude, c))
+            {
+                ++counter[c];
+            }
+        }
+        return static_cast<long>(counter.size()) * 1'000'000 + counter['a'];
+    };
+    auto lookup = [](const auto& exclude, char c) { return exclude.contains(c); };
+    std::set<char> tree_set(excluded, excluded + 16);
+    std::unordered_set<char> hash_set(excluded, excluded + 16);
+    flat_hash_set<char> flat_set;
+    for (char c : std::string(excluded))
+    {
+        flat_set.insert(c);
+    }
+
+    std::map<char, int> expect_counter;
+    long expect = count(tree_set, expect_counter, lookup);
+    long n = static_cast<long>(text.size());
+    std::cout << "character counter, " << n << " characters:" << std::endl;
+    bench("set + map", n, expect, [&] {
+        std::map<char, int> counter;
+        return count(tree_set, counter, lookup);
+    });
+    bench("unordered_set + unordered_map", n, expect, [&] {
+        std::unordered_map<char, int> counter;
+        return count(hash_set, counter, lookup);
+    });
+    bench("flat_hash_set + flat_hash_map", n, expect, [&] {
+        flat_hash_map<char, int> counter;
+        return count(flat_set, counter, lookup);
+    });
+    bench("simd_find + flat_hash_map", n, expect, [&] {
+        flat_hash_map<char, int> counter;
+        auto is_excluded = [](const char* exclude, char c) { return *simd_find(exclude, exclude + 16, c) != 0; };
+        return count(excluded, counter, is_excluded);
+    });
+}
+
+// Membership of random ints in a set of n of them, half the queries present, then counting the
+// occurrences of random ints from [0, n) in a map.
+void bench_membership(std::mt19937& gen, int n)
+{
+    constexpr int QUERIES = 1'000'000;
+    std::vector<int> keys(n), queries(QUERIES);
+    for (auto& key : keys)
+    {
+        key = static_cast<int>(gen() >> 1);
+    }
+    for (int q = 0; q < QUERIES; q++)
+    {
+        queries[q] = q % 2 ? keys[gen() % n] : static_cast<int>(gen() >> 1);
+    }
+
+    auto hits = [&](const auto& set) {
+        long sum = 0;
+        for (int x : queries)
+        {
+            sum += set.contains(x);
+        }
+        return sum;
+    };
+    std::set<int> tree_set(keys.begin(), keys.end());
+    std::unordered_set<int> hash_set(keys.begin(), keys.end());
+    flat_hash_set<int> flat_set;
+    for (int key : keys)
+    {
+        flat_set.insert(key);
+    }
+    long expect = hits(tree_set);
+    std::cout << "contains, " << n << " ints:" << std::endl;
+    bench("std::set", QUERIES, expect, [&] { return hits(tree_set); });
+    bench("std::unordered_set", QUERIES, expect, [&] { return hits(hash_set); });
+    bench("flat_hash_set", QUERIES, expect, [&] { return hits(flat_set); });
+
+    auto tally = [&](auto& counter) {
+        for (int x : queries)
+        {
+            ++counter[x % n];
+        }
+        return static_cast<long>(counter.size()) * QUERIES + counter[0];
+    };
+    std::map<int, int> expect_counter;
+    expect = tally(expect_counter);
+    std::cout << "count into map, " << n << " distinct ints:" << std::endl;
+    bench("std::map", QUERIES, expect, [&] {
+        std::map<int, int> counter;
+        return tally(counter);
+    });
+    bench("std::unordered_map", QUERIES, expect, [&] {
+        std::unordered_map<int, int> counter;
+        return tally(counter);
+    });
+    bench("flat_hash_map", QUERIES, expect, [&] {
+        flat_hash_map<int, int> counter;
+        return tally(counter);
+    });
+}
+
+int main()
+{
+    std::mt19937 gen(20240607);
+
+    for (int n : {16, 256, 4096, 65536})
+    {
+        bench_find(gen, n);
+    }
+    bench_counter(gen);
+    for (int n : {100, 10'000, 1'000'000})
+    {
+        bench_membership(gen, n);
+    }
+
+    return 0;
+}
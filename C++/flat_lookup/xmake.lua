@@ -0,0 +1,8 @@
+set_languages("cxx20")
+
+add_rules("mode.debug", "mode.release")
+
+target("main")
+    set_kind("binary")
+    add_files("main.cpp")
+    add_vectorexts("avx2")
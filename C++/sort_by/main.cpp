@@ -0,0 +1,111 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "sort_by.hpp"
+
+using namespace sorting;
+
+// Same layout as in C/callback_sort_print_array.c.
+struct Person
+{
+    char* name;
+    int age;
+};
+
+// From C/callback_sort_print_array.c, cmp_int and cmp_double sort in descending order.
+extern "C"
+{
+    void sort_array(void* arr, int ele_size, int len, int (*cmp)(const void*, const void*));
+    int cmp_int(const void* a, const void* b);
+    int cmp_double(const void* a, const void* b);
+    int cmp_person_age(const void* a, const void* b);
+    int cmp_person_name(const void* a, const void* b);
+}
+
+constexpr int SIZE = 1'000'000;
+constexpr int TRIALS = 5;
+
+// Best time in ms of sorting a fresh copy of `data` with `sort`, checked with `is_sorted`.
+template <typename T, typename Sort, typename Check>
+void bench(const char* name, const std::vector<T>& data, Sort sort, Check is_sorted)
+{
+    double best = 1e300;
+    bool ok = true;
+    for (int i = 0; i < TRIALS; i++)
+    {
+        std::vector<T> work = data;
+        auto start = std::chrono::steady_clock::now();
+        sort(work);
+        auto stop = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(stop - start).count());
+        ok = ok && is_sorted(work);
+    }
+    std::cout << "  " << name << ":\t" << best << " ms\t" << (ok ? "ok" : "WRONG") << std::endl;
+}
+
+int main()
+{
+    std::mt19937 gen(20240607);
+
+    std::vector<int> ints(SIZE);
+    for (auto& x : ints)
+    {
+        x = static_cast<int>(gen());
+    }
+    auto ints_desc = [](const std::vector<int>& v) { return std::is_sorted(v.rbegin(), v.rend()); };
+
+    std::cout << "int, descending:" << std::endl;
+    bench("qsort", ints, [](auto& v) { qsort(v.data(), v.size(), sizeof(int), cmp_int); }, ints_desc);
+    bench("sort_array", ints, [](auto& v) { sort_array(v.data(), sizeof(int), v.size(), cmp_int); }, ints_desc);
+    bench("sort_by<desc(identity)>", ints, [](auto& v) { sort_by<desc(std::identity{})>(v); }, ints_desc);
+    bench("sort_by(desc(identity))", ints, [](auto& v) { sort_by(v, desc(std::identity{})); }, ints_desc);
+
+    std::vector<double> doubles(SIZE);
+    std::uniform_real_distribution<double> real(-1e6, 1e6);
+    for (auto& x : doubles)
+    {
+        x = real(gen);
+    }
+    auto doubles_desc = [](const std::vector<double>& v) { return std::is_sorted(v.rbegin(), v.rend()); };
+
+    std::cout << "double, descending:" << std::endl;
+    bench("qsort", doubles, [](auto& v) { qsort(v.data(), v.size(), sizeof(double), cmp_double); }, doubles_desc);
+    bench("sort_array", doubles, [](auto& v) { sort_array(v.data(), sizeof(double), v.size(), cmp_double); }, doubles_desc);
+    bench("sort_by<desc(identity)>", doubles, [](auto& v) { sort_by<desc(std::identity{})>(v); }, doubles_desc);
+
+    // 名字放在一个字符串池里，Person 只保存指针
+    std::vector<std::string> names(SIZE);
+    std::vector<Person> people(SIZE);
+    std::uniform_int_distribution<int> age(0, 100), letter('a', 'z'), length(3, 12);
+    for (int i = 0; i < SIZE; i++)
+    {
+        for (int j = length(gen); j > 0; j--)
+        {
+            names[i] += static_cast<char>(letter(gen));
+        }
+        people[i] = {names[i].data(), age(gen)};
+    }
+    auto by_age = [](const std::vector<Person>& v) {
+        return std::is_sorted(v.begin(), v.end(), [](auto& a, auto& b) { return a.age < b.age; });
+    };
+    auto by_name = [](const std::vector<Person>& v) {
+        return std::is_sorted(v.begin(), v.end(), [](auto& a, auto& b) { return std::string_view(a.name) < b.name; });
+    };
+
+    std::cout << "Person, by age:" << std::endl;
+    bench("qsort", people, [](auto& v) { qsort(v.data(), v.size(), sizeof(Person), cmp_person_age); }, by_age);
+    bench("sort_array", people, [](auto& v) { sort_array(v.data(), sizeof(Person), v.size(), cmp_person_age); }, by_age);
+    bench("sort_by<&Person::age>", people, [](auto& v) { sort_by<&Person::age>(v); }, by_age);
+    bench("sort_by(&Person::age)", people, [](auto& v) { sort_by(v, &Person::age); }, by_age);
+
+    std::cout << "Person, by name:" << std::endl;
+    bench("qsort", people, [](auto& v) { qsort(v.data(), v.size(), sizeof(Person), cmp_person_name); }, by_name);
+    bench("sort_array", people, [](auto& v) { sort_array(v.data(), sizeof(Person), v.size(), cmp_person_name); }, by_name);
+    bench("sort_by<&Person::name>", people, [](auto& v) { sort_by<&Person::name>(v); }, by_name);
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+#ifndef SORT_BY_HPP
+#define SORT_BY_HPP
+
+#include <algorithm>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+
+// Sort by a key that is a template parameter, so the compiler sees the whole comparison and can
+// inline it, instead of calling a comparator through a function pointer like qsort does:
+//
+//   sort_by(ints);                          // ascending
+//   sort_by<&Person::age>(people);          // key fixed at compile time
+//   sort_by<desc(&Person::name)>(people);   // descending
+//   sort_by(people, desc(&Person::name));   // key passed as an argument
+//
+// A key is anything std::invoke can call on an element: a data member pointer, a member function
+// pointer or a function object. Keys that are C strings compare by content.
+namespace sorting
+{
+
+// Key wrapper that reverses the order.
+template <typename Key>
+struct descending
+{
+    Key key;
+};
+
+template <typename Key>
+constexpr descending<Key> desc(Key key)
+{
+    return {key};
+}
+
+namespace detail
+{
+
+template <typename T>
+constexpr bool is_c_string_v = std::is_same_v<std::decay_t<T>, char*> || std::is_same_v<std::decay_t<T>, const char*>;
+
+template <typename T>
+constexpr decltype(auto) comparable(T&& value)
+{
+    if constexpr (is_c_string_v<T>)
+    {
+        return std::string_view(value);
+    }
+    else
+    {
+        return std::forward<T>(value);
+    }
+}
+
+template <typename Key>
+struct key_less
+{
+    Key key;
+
+    template <typename T>
+    constexpr bool operator()(const T& a, const T& b) const
+    {
+        return comparable(std::invoke(key, a)) < comparable(std::invoke(key, b));
+    }
+};
+
+template <typename Key>
+struct key_less<descending<Key>>
+{
+    descending<Key> desc;
+
+    template <typename T>
+    constexpr bool operator()(const T& a, const T& b) const
+    {
+        return comparable(std::invoke(desc.key, b)) < comparable(std::invoke(desc.key, a));
+    }
+};
+
+// Stateless comparator, the key is part of the type.
+template <auto Key>
+struct static_less
+{
+    template <typename T>
+    constexpr bool operator()(const T& a, const T& b) const
+    {
+        return key_less<std::remove_cv_t<decltype(Key)>>{Key}(a, b);
+    }
+};
+
+} // namespace detail
+
+template <auto Key = std::identity{}, typename Range>
+void sort_by(Range&& range)
+{
+    std::sort(std::begin(range), std::end(range), detail::static_less<Key>{});
+}
+
+template <typename Range, typename Key>
+void sort_by(Range&& range, Key key)
+{
+    std::sort(std::begin(range), std::end(range), detail::key_less<Key>{key});
+}
+
+// Equal keys keep their order.
+template <auto Key = std::identity{}, typename Range>
+void stable_sort_by(Range&& range)
+{
+    std::stable_sort(std::begin(range), std::end(range), detail::static_less<Key>{});
+}
+
+template <typename Range, typename Key>
+void stable_sort_by(Range&& range, Key key)
+{
+    std::stable_sort(std::begin(range), std::end(range), detail::key_less<Key>{key});
+}
+
+} // namespace sorting
+
+#endif // SORT_BY_HPP
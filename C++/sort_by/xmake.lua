@@ -0,0 +1,9 @@
+set_languages("cxx20")
+
+add_rules("mode.debug", "mode.release")
+
+target("main")
+    set_kind("binary")
+    add_files("main.cpp")
+    -- sort_array() and the comparators of the C demo, without its main()
+    add_files("../../C/callback_sort_print_array.c", {defines = "main=callback_sort_print_array_main"})
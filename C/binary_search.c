@@ -1,5 +1,16 @@
 #include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 int binary_search(int arr[], int size, int element)
 {
@@ -23,7 +34,907 @@ int binary_search(int arr[], int size, int element)
     return -1; // not found
 }
 
-int main(void)
+// Static search index, built once from a sorted array, answering lower_bound queries: the position
+// in the sorted array of the first key not less than x, or n if there is none. Beyond the L2 cache
+// every probe of binary_search() is a cache miss, so the layouts below put the keys a search reads
+// close together:
+//
+//   LAYOUT_SORTED     the sorted array itself, searched without branches, prefetching both next probes
+//   LAYOUT_EYTZINGER  the keys in BFS order of the implicit binary search tree, node k has children 2k
+//                     and 2k + 1, so the 16 nodes 4 levels below k share one cache line to prefetch
+//   LAYOUT_STREE      a static B+ tree of 16-key nodes, one cache line each, compared 8 keys at a time
+//                     with AVX2, whose leaves are the sorted array
+//
+// index_lower_bound_batch() runs INDEX_BATCH queries in lockstep, so their cache misses overlap.
+
+enum layout
+{
+    LAYOUT_SORTED,
+    LAYOUT_EYTZINGER,
+    LAYOUT_STREE,
+    LAYOUT_COUNT
+};
+
+const char* layout_names[LAYOUT_COUNT] = {"sorted", "eytzinger", "s-tree"};
+
+// Keys per S-tree node, an inner node has STREE_B + 1 children.
+#define STREE_B 16
+
+// Most layers of an S-tree, 17^8 blocks of 16 keys is far beyond INT_MAX keys.
+#define STREE_MAX_HEIGHT 8
+
+// Queries run together by index_lower_bound_batch().
+#define INDEX_BATCH 32
+
+#define CACHE_LINE 64
+
+struct static_index
+{
+    enum layout layout;
+    int n;
+    int* keys;  // sorted: n keys, eytzinger: keys[1, n], s-tree: the layers from the root down
+    int* rank;  // eytzinger: position in the sorted array of keys[k]
+    int height; // s-tree layers, 0 is the leaves
+    int offset[STREE_MAX_HEIGHT];
+};
+
+static void* aligned_malloc(size_t size)
+{
+    void* p = aligned_alloc(CACHE_LINE, (size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE);
+    if (p == NULL)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+// Fill the subtree of node k in order from sorted[i], return the position after the last key used.
+static int eytzinger_fill(struct static_index* index, const int sorted[], int i, int k)
+{
+    if (k <= index->n)
+    {
+        i = eytzinger_fill(index, sorted, i, 2 * k);
+        index->keys[k] = sorted[i];
+        index->rank[k] = i++;
+        i = eytzinger_fill(index, sorted, i, 2 * k + 1);
+    }
+    return i;
+}
+
+static void stree_build(struct static_index* index, const int sorted[], int n)
+{
+    // 每层的块数，叶子层是补齐到 16 的整数倍的有序数组
+    long blocks[STREE_MAX_HEIGHT];
+    blocks[0] = (n + STREE_B - 1) / STREE_B;
+    blocks[0] = blocks[0] > 0 ? blocks[0] : 1;
+    index->height = 1;
+    while (blocks[index->height - 1] > 1)
+    {
+        blocks[index->height] = (blocks[index->height - 1] + STREE_B) / (STREE_B + 1);
+        index->height++;
+    }
+
+    // 根在最前面，越往下的层越靠后
+    long total = 0;
+    for (int h = index->height - 1; h >= 0; h--)
+    {
+        index->offset[h] = (int)total;
+        total += blocks[h] * STREE_B;
+    }
+    index->keys = (int*)aligned_malloc(total * sizeof(int));
+
+    int* leaves = index->keys + index->offset[0];
+    memcpy(leaves, sorted, n * sizeof(int));
+    for (long i = n; i < blocks[0] * STREE_B; i++)
+    {
+        leaves[i] = INT_MAX;
+    }
+
+    // 内部结点的第 i 个键是第 i + 1 个孩子子树中最左边叶子的第一个键
+    long span = 1; // leaf blocks under a node of layer h - 1
+    for (int h = 1; h < index->height; h++)
+    {
+        int* layer = index->keys + index->offset[h];
+        for (long j = 0; j < blocks[h]; j++)
+        {
+            for (int i = 0; i < STREE_B; i++)
+            {
+                long leaf = (j * (STREE_B + 1) + i + 1) * span;
+                layer[j * STREE_B + i] = leaf < blocks[0] ? leaves[leaf * STREE_B] : INT_MAX;
+            }
+        }
+        span *= STREE_B + 1;
+    }
+}
+
+void index_build(struct static_index* index, const int sorted[], int n, enum layout layout)
+{
+    index->layout = layout;
+    index->n = n;
+    index->rank = NULL;
+    index->height = 0;
+    switch (layout)
+    {
+        case LAYOUT_SORTED:
+            index->keys = (int*)aligned_malloc((n > 0 ? n : 1) * sizeof(int));
+            memcpy(index->keys, sorted, n * sizeof(int));
+            break;
+        case LAYOUT_EYTZINGER:
+            index->keys = (int*)aligned_malloc((n + 1) * sizeof(int));
+            index->rank = (int*)aligned_malloc((n + 1) * sizeof(int));
+            eytzinger_fill(index, sorted, 0, 1);
+            break;
+        default:
+            stree_build(index, sorted, n);
+            break;
+    }
+}
+
+void index_free(struct static_index* index)
+{
+    free(index->keys);
+    free(index->rank);
+}
+
+// Number of the 16 sorted keys of a node less than x.
+static inline int node_rank(const int node[], int x)
+{
+#if defined(__AVX2__)
+    __m256i key = _mm256_set1_epi32(x);
+    __m256i lo = _mm256_cmpgt_epi32(key, _mm256_load_si256((const __m256i*)node));
+    __m256i hi = _mm256_cmpgt_epi32(key, _mm256_load_si256((const __m256i*)(node + 8)));
+    unsigned mask = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(lo)) |
+                    (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(hi)) << 8;
+    return __builtin_popcount(mask);
+#else
+    int count = 0;
+    for (int i = 0; i < STREE_B; i++)
+    {
+        count += node[i] < x;
+    }
+    return count;
+#endif
+}
+
+static inline int sorted_lower_bound(const int arr[], int n, int x)
+{
+    const int* base = arr;
+    while (n > 1)
+    {
+        int half = n / 2;
+        n -= half;
+        __builtin_prefetch(&base[n / 2 - 1]);
+        __builtin_prefetch(&base[half + n / 2 - 1]);
+        base = base[half - 1] < x ? base + half : base;
+    }
+    return (int)(base - arr) + (n == 1 && *base < x);
+}
+
+static inline int eytzinger_lower_bound(const struct static_index* index, int x)
+{
+    const int* keys = index->keys;
+    long k = 1;
+    while (k <= index->n)
+    {
+        __builtin_prefetch(keys + k * 16);
+        k = 2 * k + (keys[k] < x);
+    }
+    // 最后一次向右之后的那次向左就是答案，去掉末尾的 1 和它后面那个 0
+    k >>= __builtin_ffsl(~k);
+    return k == 0 ? index->n : index->rank[k];
+}
+
+static inline int stree_lower_bound(const struct static_index* index, int x)
+{
+    long k = 0;
+    for (int h = index->height - 1; h > 0; h--)
+    {
+        k = k * (STREE_B + 1) + node_rank(index->keys + index->offset[h] + k * STREE_B, x);
+    }
+    long r = k * STREE_B + node_rank(index->keys + index->offset[0] + k * STREE_B, x);
+    return r < index->n ? (int)r : index->n;
+}
+
+int index_lower_bound(const struct static_index* index, int x)
+{
+    switch (index->layout)
+    {
+        case LAYOUT_SORTED:
+            return sorted_lower_bound(index->keys, index->n, x);
+        case LAYOUT_EYTZINGER:
+            return eytzinger_lower_bound(index, x);
+        default:
+            return stree_lower_bound(index, x);
+    }
+}
+
+// Queries xs[0, m) of one batch, advanced a level at a time each.
+static void sorted_batch(const struct static_index* index, const int xs[], int m, int out[])
+{
+    const int* arr = index->keys;
+    int base[INDEX_BATCH] = {0};
+    int n = index->n;
+    while (n > 1)
+    {
+        int half = n / 2;
+        n -= half;
+        for (int j = 0; j < m; j++)
+        {
+            base[j] = arr[base[j] + half - 1] < xs[j] ? base[j] + half : base[j];
+            __builtin_prefetch(&arr[base[j] + n / 2 - 1]);
+        }
+    }
+    for (int j = 0; j < m; j++)
+    {
+        out[j] = base[j] + (n == 1 && arr[base[j]] < xs[j]);
+    }
+}
+
+static void eytzinger_batch(const struct static_index* index, const int xs[], int m, int out[])
+{
+    const int* keys = index->keys;
+    long k[INDEX_BATCH];
+    for (int j = 0; j < m; j++)
+    {
+        k[j] = 1;
+    }
+
+    // 完全填满的层所有查询都走，最后一层只有部分结点
+    int full = 0;
+    while ((2L << full) - 1 <= index->n)
+    {
+        full++;
+    }
+    for (int level = 0; level < full; level++)
+    {
+        for (int j = 0; j < m; j++)
+        {
+            __builtin_prefetch(keys + k[j] * 16);
+            k[j] = 2 * k[j] + (keys[k[j]] < xs[j]);
+        }
+    }
+    for (int j = 0; j < m; j++)
+    {
+        if (k[j] <= index->n)
+        {
+            k[j] = 2 * k[j] + (keys[k[j]] < xs[j]);
+        }
+        k[j] >>= __builtin_ffsl(~k[j]);
+        out[j] = k[j] == 0 ? index->n : index->rank[k[j]];
+    }
+}
+
+static void stree_batch(const struct static_index* index, const int xs[], int m, int out[])
+{
+    long k[INDEX_BATCH] = {0};
+    for (int h = index->height - 1; h > 0; h--)
+    {
+        const int* layer = index->keys + index->offset[h];
+        const int* below = index->keys + index->offset[h - 1];
+        for (int j = 0; j < m; j++)
+        {
+            k[j] = k[j] * (STREE_B + 1) + node_rank(layer + k[j] * STREE_B, xs[j]);
+            __builtin_prefetch(below + k[j] * STREE_B);
+        }
+    }
+    const int* leaves = index->keys + index->offset[0];
+    for (int j = 0; j < m; j++)
+    {
+        long r = k[j] * STREE_B + node_rank(leaves + k[j] * STREE_B, xs[j]);
+        out[j] = r < index->n ? (int)r : index->n;
+    }
+}
+
+void index_lower_bound_batch(const struct static_index* index, const int xs[], int m, int out[])
+{
+    for (int i = 0; i < m; i += INDEX_BATCH)
+    {
+        int size = m - i < INDEX_BATCH ? m - i : INDEX_BATCH;
+        switch (index->layout)
+        {
+            case LAYOUT_SORTED:
+                sorted_batch(index, xs + i, size, out + i);
+                break;
+            case LAYOUT_EYTZINGER:
+                eytzinger_batch(index, xs + i, size, out + i);
+                break;
+            default:
+                stree_batch(index, xs + i, size, out + i);
+                break;
+        }
+    }
+}
+
+// Learned index over a sorted array of int or int64_t keys: a piecewise linear model of the position
+// of every key, in the style of the PGM index. Segments are built greedily by a shrinking cone: each
+// predicts the lower bound of any key in its range to within LEARNED_EPSILON positions. A table on the
+// top bits of the key, as in RadixSpline, narrows the search for the segment to a few entries, and a
+// binary search of the error window finishes the lookup: about log2(2 * LEARNED_EPSILON) probes, all
+// in a few neighbouring cache lines, instead of log2(n) probes over the whole array.
+
+// Largest distance between the predicted and the true position.
+#define LEARNED_EPSILON 32
+
+// Most bits of the radix table over the segments.
+#define LEARNED_RADIX_BITS 20
+
+struct learned_segment
+{
+    int64_t key; // first key covered
+    long pos;    // its lower bound
+    double slope;
+};
+
+struct learned_index
+{
+    const void* keys; // not copied, must outlive the index
+    int width;        // sizeof(int) or sizeof(int64_t)
+    long n;
+    struct learned_segment* segments;
+    int count;
+    int capacity;
+    int* table; // table[b]: first segment whose key has top bits b or more
+    long buckets;
+    int shift;
+    int64_t min;
+};
+
+static inline int64_t key_at(const struct learned_index* index, long i)
+{
+    return index->width == sizeof(int) ? ((const int*)index->keys)[i] : ((const int64_t*)index->keys)[i];
+}
+
+// Distance between two keys, a < b is allowed to span the whole int64_t range.
+static inline uint64_t key_distance(int64_t a, int64_t b)
+{
+    return (uint64_t)b - (uint64_t)a;
+}
+
+// State of the segment being built: its first point and the range of slopes that keep every point
+// seen since within the error window.
+struct cone
+{
+    int64_t key;
+    long pos;
+    double lo;
+    double hi;
+    bool open;
+};
+
+static void add_segment(struct learned_index* index, const struct cone* cone)
+{
+    if (index->count == index->capacity)
+    {
+        index->capacity = index->capacity ? 2 * index->capacity : 64;
+        index->segments =
+            (struct learned_segment*)realloc(index->segments, index->capacity * sizeof(struct learned_segment));
+        if (index->segments == NULL)
+        {
+            fprintf(stderr, "ERROR: Memory allocation failed.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    struct learned_segment* s = &index->segments[index->count++];
+    s->key = cone->key;
+    s->pos = cone->pos;
+    s->slope = cone->hi == INFINITY ? 0 : (cone->lo + cone->hi) / 2;
+}
+
+static void add_point(struct learned_index* index, struct cone* cone, int64_t key, long pos)
+{
+    if (cone->open)
+    {
+        double dx = (double)key_distance(cone->key, key);
+        double lo = (double)(pos - LEARNED_EPSILON - cone->pos) / dx;
+        double hi = (double)(pos + LEARNED_EPSILON - cone->pos) / dx;
+        lo = lo > cone->lo ? lo : cone->lo;
+        hi = hi < cone->hi ? hi : cone->hi;
+        if (lo <= hi)
+        {
+            cone->lo = lo;
+            cone->hi = hi;
+            return;
+        }
+        add_segment(index, cone);
+    }
+    cone->key = key;
+    cone->pos = pos;
+    cone->lo = 0;
+    cone->hi = INFINITY;
+    cone->open = true;
+}
+
+void learned_build(struct learned_index* index, const void* keys, int width, long n)
+{
+    index->keys = keys;
+    index->width = width;
+    index->n = n;
+    index->segments = NULL;
+    index->count = 0;
+    index->capacity = 0;
+    index->table = NULL;
+    index->buckets = 0;
+    if (n == 0)
+    {
+        return;
+    }
+
+    // The lower bound of x is the first position of the smallest key >= x, so the model has to fit
+    // both (k, first position of k) and (k + 1, first position of the next key) for every key k.
+    struct cone cone = {0, 0, 0, 0, false};
+    for (long i = 0; i < n;)
+    {
+        int64_t key = key_at(index, i);
+        long next = i + 1;
+        while (next < n && key_at(index, next) == key)
+        {
+            next++;
+        }
+        add_point(index, &cone, key, i);
+        if (next < n && key + 1 < key_at(index, next))
+        {
+            add_point(index, &cone, key + 1, next);
+        }
+        i = next;
+    }
+    add_segment(index, &cone);
+
+    // Radix table on the top bits of key - min, about two entries per segment.
+    index->min = key_at(index, 0);
+    uint64_t range = key_distance(index->min, key_at(index, n - 1));
+    int bits = range ? 64 - __builtin_clzll(range) : 0;
+    int radix = 1;
+    while ((1L << radix) < 2L * index->count && radix < LEARNED_RADIX_BITS)
+    {
+        radix++;
+    }
+    index->shift = bits > radix ? bits - radix : 0;
+    long size = (long)(range >> index->shift) + 2;
+    index->buckets = size;
+    index->table = (int*)malloc(size * sizeof(int));
+    if (index->table == NULL)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    int s = 0;
+    for (long b = 0; b < size; b++)
+    {
+        while (s < index->count && (long)(key_distance(index->min, index->segments[s].key) >> index->shift) < b)
+        {
+            s++;
+        }
+        index->table[b] = s;
+    }
+}
+
+void learned_free(struct learned_index* index)
+{
+    free(index->segments);
+    free(index->table);
+}
+
+// First position in [lo, hi) whose key is not less than x, without branches.
+static inline long window_lower_bound(const struct learned_index* index, long lo, long hi, int64_t x)
+{
+    long n = hi - lo;
+    if (index->width == sizeof(int))
+    {
+        const int* base = (const int*)index->keys + lo;
+        while (n > 1)
+        {
+            long half = n / 2;
+            base = base[half - 1] < x ? base + half : base;
+            n -= half;
+        }
+        return base - (const int*)index->keys + (n == 1 && *base < x);
+    }
+    const int64_t* base = (const int64_t*)index->keys + lo;
+    while (n > 1)
+    {
+        long half = n / 2;
+        base = base[half - 1] < x ? base + half : base;
+        n -= half;
+    }
+    return base - (const int64_t*)index->keys + (n == 1 && *base < x);
+}
+
+long learned_lower_bound(const struct learned_index* index, int64_t x)
+{
+    long n = index->n;
+    if (n == 0 || x <= key_at(index, 0))
+    {
+        return 0;
+    }
+    if (x > key_at(index, n - 1))
+    {
+        return n;
+    }
+
+    // The segment is the last one starting at or below x: the last one of a lower bucket or one of
+    // the bucket of x.
+    long b = (long)(key_distance(index->min, x) >> index->shift);
+    int lo = index->table[b] > 0 ? index->table[b] - 1 : 0;
+    int count = index->table[b + 1] - lo;
+    while (count > 1)
+    {
+        int half = count / 2;
+        lo = index->segments[lo + half].key <= x ? lo + half : lo;
+        count -= half;
+    }
+    const struct learned_segment* s = &index->segments[lo];
+
+    // Between the last key of a segment and the first of the next, the answer is where the next starts.
+    long end = lo + 1 < index->count ? s[1].pos : n;
+    double predict = s->pos + s->slope * (double)key_distance(s->key, x);
+    long pos = predict < (double)end ? (long)predict : end;
+    long first = pos - LEARNED_EPSILON - 1 > 0 ? pos - LEARNED_EPSILON - 1 : 0;
+    long last = pos + LEARNED_EPSILON + 2 < n ? pos + LEARNED_EPSILON + 2 : n;
+
+    // The bound only fails by a rounding of the slope, then search everything.
+    if ((first > 0 && key_at(index, first - 1) >= x) || (last < n && key_at(index, last) < x))
+    {
+        return window_lower_bound(index, 0, n, x);
+    }
+    return window_lower_bound(index, first, last, x);
+}
+
+// The branchless lower bound of LAYOUT_SORTED on int64_t keys, the baseline of the learned index.
+static inline long int64_lower_bound(const int64_t arr[], long n, int64_t x)
+{
+    const int64_t* base = arr;
+    while (n > 1)
+    {
+        long half = n / 2;
+        n -= half;
+        __builtin_prefetch(&base[n / 2 - 1]);
+        __builtin_prefetch(&base[half + n / 2 - 1]);
+        base = base[half - 1] < x ? base + half : base;
+    }
+    return (base - arr) + (n == 1 && *base < x);
+}
+
+static int int_cmp(const void* a, const void* b)
+{
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static int random_int(void)
+{
+    return (int)(((unsigned)rand() << 16) ^ (unsigned)rand());
+}
+
+// Every layout and the batched queries against a plain lower bound, on sizes around the node and batch sizes.
+void test_index(void)
+{
+    int sizes[] = {0, 1, 2, 15, 16, 17, 31, 100, 271, 272, 289, 1000, 4913, 65536, 100003};
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++)
+    {
+        int n = sizes[s];
+        int* sorted = (int*)malloc((n + 1) * sizeof(int));
+        int xs[500], out[500];
+        for (int i = 0; i < n; i++)
+        {
+            sorted[i] = random_int() % (n * 4 + 1) - n; // duplicates and negative keys
+        }
+        qsort(sorted, n, sizeof(int), int_cmp);
+        for (int q = 0; q < 500; q++)
+        {
+            xs[q] = q < 4 ? (int[]){INT_MIN, INT_MAX, -n - 1, 3 * n + 1}[q] : random_int() % (n * 4 + 3) - n - 1;
+        }
+
+        for (int layout = 0; layout < LAYOUT_COUNT; layout++)
+        {
+            struct static_index index;
+            index_build(&index, sorted, n, layout);
+            index_lower_bound_batch(&index, xs, 500, out);
+            for (int q = 0; q < 500; q++)
+            {
+                int expect = 0;
+                while (expect < n && sorted[expect] < xs[q])
+                {
+                    expect++;
+                }
+                assert(index_lower_bound(&index, xs[q]) == expect);
+                assert(out[q] == expect);
+            }
+            index_free(&index);
+        }
+        free(sorted);
+    }
+}
+
+// Random queries into n random keys with binary_search() and every layout, one by one and batched.
+void time_index(int n, int m)
+{
+    int* sorted = (int*)malloc(n * sizeof(int));
+    int* xs = (int*)malloc(m * sizeof(int));
+    int* out = (int*)malloc(m * sizeof(int));
+    if (sorted == NULL || xs == NULL || out == NULL)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < n; i++)
+    {
+        sorted[i] = random_int();
+    }
+    qsort(sorted, n, sizeof(int), int_cmp);
+    for (int q = 0; q < m; q++)
+    {
+        xs[q] = random_int();
+    }
+
+    printf("%d keys, %d queries, ns per query:\n", n, m);
+    long sum = 0;
+    clock_t start = clock();
+    for (int q = 0; q < m; q++)
+    {
+        sum += binary_search(sorted, n, xs[q]);
+    }
+    double base = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / m;
+    printf("  %-12s%10.1f\n", "binary", base);
+
+    long expect = -1;
+    for (int layout = 0; layout < LAYOUT_COUNT; layout++)
+    {
+        struct static_index index;
+        index_build(&index, sorted, n, layout);
+
+        sum = 0;
+        start = clock();
+        for (int q = 0; q < m; q++)
+        {
+            sum += index_lower_bound(&index, xs[q]);
+        }
+        double single = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / m;
+
+        start = clock();
+        index_lower_bound_batch(&index, xs, m, out);
+        double batch = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / m;
+        long batch_sum = 0;
+        for (int q = 0; q < m; q++)
+        {
+            batch_sum += out[q];
+        }
+
+        expect = expect < 0 ? sum : expect;
+        printf("  %-12s%10.1f  batched %6.1f  %s\n", layout_names[layout], single, batch,
+               sum == expect && batch_sum == expect ? "ok" : "WRONG");
+        index_free(&index);
+    }
+
+    free(sorted);
+    free(xs);
+    free(out);
+}
+
+static int int64_cmp(const void* a, const void* b)
+{
+    int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+enum distribution
+{
+    DIST_UNIFORM,
+    DIST_LOGNORMAL,
+    DIST_CLUSTERED,
+    DIST_COUNT
+};
+
+static const char* distribution_names[DIST_COUNT] = {"uniform", "lognormal", "clustered"};
+
+// Standard normal value from two rand() draws, by the Box-Muller transform.
+static double random_normal(void)
+{
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0), v = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+// n sorted keys in [0, limit]: uniform, lognormal (dense at the low end, a long sparse tail), or in
+// 100 narrow clusters at random places.
+static void random_keys(int64_t keys[], long n, int64_t limit, enum distribution dist)
+{
+    int64_t centers[100];
+    for (int c = 0; c < 100; c++)
+    {
+        centers[c] = (int64_t)((double)rand() / RAND_MAX * limit);
+    }
+    for (long i = 0; i < n; i++)
+    {
+        double x;
+        switch (dist)
+        {
+            case DIST_UNIFORM:
+                x = (double)(((uint64_t)rand() << 31) ^ (uint64_t)rand()) / ((double)RAND_MAX * 2147483648.0) * limit;
+                break;
+            case DIST_LOGNORMAL:
+                x = exp(2 * random_normal()) * (limit / 1e4);
+                break;
+            default:
+                x = centers[rand() % 100] + random_normal() * (limit / 1e5);
+                break;
+        }
+        keys[i] = x < 0 ? 0 : x > (double)limit ? limit : (int64_t)x;
+    }
+    qsort(keys, n, sizeof(int64_t), int64_cmp);
+}
+
+// Lower bound by a linear scan of the keys of the index.
+static long linear_lower_bound(const struct learned_index* index, int64_t x)
+{
+    long i = 0;
+    while (i < index->n && key_at(index, i) < x)
+    {
+        i++;
+    }
+    return i;
+}
+
+// The learned index on int and int64_t keys of every distribution against a plain lower bound.
+void test_learned(void)
+{
+    long sizes[] = {0, 1, 2, 3, 64, 65, 1000, 100003};
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++)
+    {
+        long n = sizes[s];
+        int64_t* keys = (int64_t*)malloc((n + 1) * sizeof(int64_t));
+        int* small = (int*)malloc((n + 1) * sizeof(int));
+        for (int dist = 0; dist < DIST_COUNT; dist++)
+        {
+            for (int wide = 0; wide < 2; wide++)
+            {
+                // 密集时有大量重复键，稀疏时键之间有空隙；int 键单独生成，再平移出负数
+                int64_t small_limit = wide ? INT_MAX : n * 4 + 1;
+                int64_t offset = wide ? INT_MAX / 2 : n;
+                random_keys(keys, n, small_limit, dist);
+                for (long i = 0; i < n; i++)
+                {
+                    small[i] = (int)(keys[i] - offset);
+                }
+                int64_t limit = wide ? INT64_MAX / 2 : n * 4 + 1;
+                random_keys(keys, n, limit, dist);
+
+                struct learned_index index, small_index;
+                learned_build(&index, keys, sizeof(int64_t), n);
+                learned_build(&small_index, small, sizeof(int), n);
+                for (int q = 0; q < 500; q++)
+                {
+                    int64_t x = n > 0 && q % 2 ? keys[rand() % n] + q % 3 - 1
+                                               : (int64_t)((double)rand() / RAND_MAX * limit * 1.1);
+                    x = q < 2 ? (q ? INT64_MAX : INT64_MIN) : x;
+                    assert(learned_lower_bound(&index, x) == linear_lower_bound(&index, x));
+
+                    int64_t y = n > 0 && q % 2 ? small[rand() % n] + q % 3 - 1
+                                               : (int64_t)((double)rand() / RAND_MAX * small_limit * 1.1) - offset;
+                    y = q < 2 ? (q ? INT_MAX : INT_MIN) : y;
+                    assert(learned_lower_bound(&small_index, y) == linear_lower_bound(&small_index, y));
+                }
+                learned_free(&index);
+                learned_free(&small_index);
+            }
+        }
+        free(keys);
+        free(small);
+    }
+}
+
+// Build times and random lookups of the learned index against binary_search() and the branchless
+// lower bound of LAYOUT_SORTED, on n keys of every distribution, as int and as int64_t. Half of the
+// m queries are keys of the array, half are random values in its range.
+void time_learned(long n, int m)
+{
+    int64_t* keys = (int64_t*)malloc(n * sizeof(int64_t));
+    int* small = (int*)malloc(n * sizeof(int));
+    int64_t* xs = (int64_t*)malloc(m * sizeof(int64_t));
+    int* small_xs = (int*)malloc(m * sizeof(int));
+    if (keys == NULL || small == NULL || xs == NULL || small_xs == NULL)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failed.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("%ld keys, %d queries, learned index with error %d:\n", n, m, LEARNED_EPSILON);
+    printf("  %-10s%-7s%9s%9s%10s%10s%10s%10s%10s\n", "keys", "type", "segments", "KB", "build ms", "stree ms",
+           "binary", "sorted", "learned");
+    for (int dist = 0; dist < DIST_COUNT; dist++)
+    {
+        for (int wide = 0; wide < 2; wide++)
+        {
+            random_keys(keys, n, wide ? INT64_MAX / 2 : INT_MAX, dist);
+            for (int q = 0; q < m; q++)
+            {
+                xs[q] = q % 2 ? keys[rand() % n] : keys[0] + (int64_t)((double)rand() / RAND_MAX * (keys[n - 1] - keys[0]));
+            }
+            const void* data = keys;
+            if (!wide)
+            {
+                for (long i = 0; i < n; i++)
+                {
+                    small[i] = (int)keys[i];
+                }
+                for (int q = 0; q < m; q++)
+                {
+                    small_xs[q] = (int)xs[q];
+                }
+                data = small;
+            }
+
+            struct learned_index index;
+            clock_t start = clock();
+            learned_build(&index, data, wide ? sizeof(int64_t) : sizeof(int), n);
+            double build = (double)(clock() - start) / CLOCKS_PER_SEC * 1e3;
+            double kb = (index.count * sizeof(struct learned_segment) + index.buckets * sizeof(int)) / 1024.0;
+
+            // The S-tree is built over int keys only.
+            double stree = 0, binary = 0, sorted = 0;
+            long expect = 0, sum = 0;
+            if (!wide)
+            {
+                struct static_index tree;
+                start = clock();
+                index_build(&tree, small, (int)n, LAYOUT_STREE);
+                stree = (double)(clock() - start) / CLOCKS_PER_SEC * 1e3;
+                index_free(&tree);
+
+                start = clock();
+                for (int q = 0; q < m; q++)
+                {
+                    sum += binary_search(small, (int)n, small_xs[q]);
+                }
+                binary = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / m;
+
+                start = clock();
+                for (int q = 0; q < m; q++)
+                {
+                    expect += sorted_lower_bound(small, (int)n, small_xs[q]);
+                }
+                sorted = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / m;
+            }
+            else
+            {
+                start = clock();
+                for (int q = 0; q < m; q++)
+                {
+                    expect += int64_lower_bound(keys, n, xs[q]);
+                }
+                sorted = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / m;
+            }
+
+            sum = 0;
+            start = clock();
+            for (int q = 0; q < m; q++)
+            {
+                sum += learned_lower_bound(&index, wide ? xs[q] : small_xs[q]);
+            }
+            double learned = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / m;
+
+            printf("  %-10s%-7s%9d%9.0f%10.1f", distribution_names[dist], wide ? "int64" : "int", index.count, kb, build);
+            if (wide)
+            {
+                printf("%10s%10s", "-", "-");
+            }
+            else
+            {
+                printf("%10.1f%10.1f", stree, binary);
+            }
+            printf("%10.1f%10.1f  %s\n", sorted, learned, sum == expect ? "ok" : "WRONG");
+            learned_free(&index);
+        }
+    }
+
+    free(keys);
+    free(small);
+    free(xs);
+    free(small_xs);
+}
+
+// Run the tests, then time sizes from 10^3 keys tenfold up to argv[1] (default 10^7), and the learned index at the
+// largest size.
+int main(int argc, char* argv[])
 {
     int arr[] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
     int size = sizeof(arr) / sizeof(arr[0]);
@@ -34,7 +945,17 @@ int main(void)
     assert(binary_search(arr, size, 9) == 8);
     assert(binary_search(arr, size, 10) == -1);
 
+    test_index();
+    test_learned();
+
     printf("Test OK.\n");
 
+    long max = argc > 1 ? atol(argv[1]) : 10000000;
+    for (long n = 1000; n <= max; n *= 10)
+    {
+        time_index((int)n, 4000000);
+    }
+    time_learned(max, 4000000);
+
     return 0;
 }
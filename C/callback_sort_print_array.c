@@ -1,4 +1,5 @@
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -49,54 +50,283 @@ void print_person(const void* data)
 callback sort funtions
 */
 
-void sort_array(void* arr, int ele_size, int len, int (*cmp)(const void*, const void*))
+// Elements of at least this size are sorted through an array of pointers, then moved once.
+#define INDIRECT_MIN_SIZE 16
+#define INDIRECT_MIN_LEN 64
+
+// Ranges smaller than this are finished by insertion sort.
+#define INSERTION_THRESHOLD 16
+
+struct sorter
+{
+    size_t size;
+    int (*cmp)(const void*, const void*);
+    bool indirect; // the elements are pointers to the real ones
+};
+
+static inline int compare(const struct sorter* s, const char* a, const char* b)
 {
-    char* temp = malloc(ele_size);
-    for (int i = 0; i < len - 1; i++)
+    return s->indirect ? s->cmp(*(char* const*)a, *(char* const*)b) : s->cmp(a, b);
+}
+
+// Swap two elements, with word-sized paths for the common sizes instead of byte copies.
+static inline void swap_elements(char* a, char* b, size_t size)
+{
+    uint64_t x, y;
+    switch (size)
     {
-        bool swapped = false;
-        for (int j = 0; j < len - i - 1; j++)
+        case 4:
         {
-            char* ele_addr = (char*)arr + ele_size * j;
-            char* next_ele_addr = (char*)arr + ele_size * (j + 1);
-            if (cmp(ele_addr, next_ele_addr))
+            uint32_t t;
+            memcpy(&t, a, 4);
+            memcpy(a, b, 4);
+            memcpy(b, &t, 4);
+            return;
+        }
+        case 8:
+            memcpy(&x, a, 8);
+            memcpy(a, b, 8);
+            memcpy(b, &x, 8);
+            return;
+        case 16:
+            memcpy(&x, a, 8);
+            memcpy(&y, a + 8, 8);
+            memcpy(a, b, 16);
+            memcpy(b, &x, 8);
+            memcpy(b + 8, &y, 8);
+            return;
+        default:
+            if (size % 8 == 0)
+            {
+                for (size_t i = 0; i < size; i += 8)
+                {
+                    memcpy(&x, a + i, 8);
+                    memcpy(a + i, b + i, 8);
+                    memcpy(b + i, &x, 8);
+                }
+            }
+            else
             {
-                memcpy(temp, next_ele_addr, ele_size);
-                memcpy(next_ele_addr, ele_addr, ele_size);
-                memcpy(ele_addr, temp, ele_size);
-                swapped = true;
+                for (size_t i = 0; i < size; i++)
+                {
+                    char t = a[i];
+                    a[i] = b[i];
+                    b[i] = t;
+                }
             }
+            return;
+    }
+}
+
+static void insertion_sort(const struct sorter* s, char* base, size_t n)
+{
+    for (size_t i = 1; i < n; i++)
+    {
+        for (char* p = base + i * s->size; p > base && compare(s, p - s->size, p) > 0; p -= s->size)
+        {
+            swap_elements(p - s->size, p, s->size);
+        }
+    }
+}
+
+static void perc_down(const struct sorter* s, char* base, size_t r, size_t n)
+{
+    for (size_t child = 2 * r + 1; child < n; r = child, child = 2 * r + 1)
+    {
+        if (child + 1 < n && compare(s, base + child * s->size, base + (child + 1) * s->size) < 0)
+        {
+            child++;
         }
-        if (swapped == false)
+        if (compare(s, base + r * s->size, base + child * s->size) >= 0)
         {
             break;
         }
+        swap_elements(base + r * s->size, base + child * s->size, s->size);
+    }
+}
+
+static void heap_sort(const struct sorter* s, char* base, size_t n)
+{
+    for (size_t i = n / 2; i-- > 0;)
+    {
+        perc_down(s, base, i, n);
+    }
+    for (size_t i = n - 1; i > 0; i--)
+    {
+        swap_elements(base, base + i * s->size, s->size);
+        perc_down(s, base, 0, i);
+    }
+}
+
+static inline void sort3(const struct sorter* s, char* a, char* b, char* c)
+{
+    if (compare(s, b, a) < 0)
+    {
+        swap_elements(a, b, s->size);
+    }
+    if (compare(s, c, b) < 0)
+    {
+        swap_elements(b, c, s->size);
+    }
+    if (compare(s, b, a) < 0)
+    {
+        swap_elements(a, b, s->size);
+    }
+}
+
+// Introsort: median-of-three Hoare partition, recurse into the smaller side, heap sort when the depth runs out.
+static void intro_sort(const struct sorter* s, char* base, size_t n, int depth)
+{
+    size_t size = s->size;
+    while (n > INSERTION_THRESHOLD)
+    {
+        if (depth-- == 0)
+        {
+            heap_sort(s, base, n);
+            return;
+        }
+
+        // 枢轴放到首位，末位不小于枢轴，作为左扫描的哨兵
+        char* mid = base + n / 2 * size;
+        char* last = base + (n - 1) * size;
+        sort3(s, base, mid, last);
+        swap_elements(base, mid, size);
+
+        size_t i = 0, j = n;
+        while (true)
+        {
+            do
+            {
+                i++;
+            } while (compare(s, base + i * size, base) < 0);
+            do
+            {
+                j--;
+            } while (compare(s, base, base + j * size) < 0);
+            if (i >= j)
+            {
+                break;
+            }
+            swap_elements(base + i * size, base + j * size, size);
+        }
+        swap_elements(base, base + j * size, size);
+
+        if (j < n - j - 1)
+        {
+            intro_sort(s, base, j, depth);
+            base += (j + 1) * size;
+            n -= j + 1;
+        }
+        else
+        {
+            intro_sort(s, base + (j + 1) * size, n - j - 1, depth);
+            n = j;
+        }
+    }
+    insertion_sort(s, base, n);
+}
+
+// Move every element to the slot of its pointer in the sorted pointer array, following the
+// cycles of the permutation so that each element is copied once.
+static void apply_permutation(char* base, size_t size, size_t len, char** sorted)
+{
+    size_t* from = malloc(len * sizeof(size_t));
+    char* temp = malloc(size);
+    if (from == NULL || temp == NULL)
+    {
+        fprintf(stderr, "ERROR: Memory allocation failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        from[i] = (sorted[i] - base) / size;
+    }
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (from[i] == i)
+        {
+            continue;
+        }
+        memcpy(temp, base + i * size, size);
+        size_t j = i;
+        while (from[j] != i)
+        {
+            memcpy(base + j * size, base + from[j] * size, size);
+            size_t next = from[j];
+            from[j] = j;
+            j = next;
+        }
+        memcpy(base + j * size, temp, size);
+        from[j] = j;
     }
+    free(from);
     free(temp);
 }
 
+// Sort `len` elements of `ele_size` bytes, cmp follows the qsort contract: negative, zero or positive
+// when the first element goes before, ties with or goes after the second one.
+void sort_array(void* arr, int ele_size, int len, int (*cmp)(const void*, const void*))
+{
+    if (len < 2 || ele_size <= 0)
+    {
+        return;
+    }
+
+    int depth = 0;
+    for (int i = len; i > 1; i >>= 1)
+    {
+        depth += 2;
+    }
+
+    // 元素较大时只排序指针，最后按排列一次性移动元素
+    if (ele_size >= INDIRECT_MIN_SIZE && len >= INDIRECT_MIN_LEN)
+    {
+        char** pointers = malloc(len * sizeof(char*));
+        if (pointers == NULL)
+        {
+            fprintf(stderr, "ERROR: Memory allocation failed.\n");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < len; i++)
+        {
+            pointers[i] = (char*)arr + (size_t)i * ele_size;
+        }
+        struct sorter s = {sizeof(char*), cmp, true};
+        intro_sort(&s, (char*)pointers, len, depth);
+        apply_permutation(arr, ele_size, len, pointers);
+        free(pointers);
+        return;
+    }
+
+    struct sorter s = {ele_size, cmp, false};
+    intro_sort(&s, arr, len, depth);
+}
+
 int cmp_int(const void* a, const void* b)
 {
-    return *(int*)a < *(int*)b; // 降序排列
+    int x = *(const int*)a, y = *(const int*)b;
+    return (y > x) - (y < x); // 降序排列
 }
 
 int cmp_double(const void* a, const void* b)
 {
-    return *(double*)a < *(double*)b; // 降序排列
+    double x = *(const double*)a, y = *(const double*)b;
+    return (y > x) - (y < x); // 降序排列
 }
 
 int cmp_person_age(const void* a, const void* b)
 {
     const struct Person* p1 = a;
     const struct Person* p2 = b;
-    return p1->age > p2->age; // 升序排列
+    return (p1->age > p2->age) - (p1->age < p2->age); // 升序排列
 }
 
 int cmp_person_name(const void* a, const void* b)
 {
     const struct Person* p1 = a;
     const struct Person* p2 = b;
-    return strcmp(p1->name, p2->name) > 0; // 升序排列
+    return strcmp(p1->name, p2->name); // 升序排列
 }
 
 /*
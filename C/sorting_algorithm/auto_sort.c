@@ -0,0 +1,162 @@
+#include "sort.h"
+
+#include <stdio.h>
+
+// Adaptive sort: profile a sample of the input and route it to the algorithm that suits it.
+//
+//   tiny input                           insertion sort
+//   small input                          quick_sort, profiling would cost more than it can save
+//   long runs, in either direction       tim_sort, which merges the runs
+//   nearly sorted or reversed with       tim_sort, the few misplaced items break the runs but
+//     shorter runs                         galloping merges still skip over most of them
+//   key range no larger than n           counting_sort
+//   few distinct keys                    quick_sort, whose equal-key grouping is O(n log distinct)
+//   nearly sorted or reversed, with      quick_sort, every partition is balanced and most items
+//     local noise everywhere               are already on the right side of the pivot
+//   large input                          radix_sort
+//   otherwise                            quick_sort
+//
+// Presortedness is estimated both from runs, which see local order, and from inversions between
+// distant sampled items, which see global order: sorted input with scattered swaps has short runs
+// but almost no inversions.
+//
+// Build with -DAUTO_SORT_DEBUG to log every profile and decision to stderr.
+
+// Inputs up to this size are sorted by insertion sort, up to AUTO_PROFILE_MIN by quick_sort, without profiling.
+#define AUTO_INSERTION_MAX 16
+#define AUTO_PROFILE_MIN 256
+
+// Largest sample, a smaller input is sampled every AUTO_SAMPLE_STEP items.
+#define AUTO_SAMPLE SIMD_SORT_MAX
+#define AUTO_SAMPLE_STEP 4
+
+// Sampled items starting a new run at most this fraction means long runs.
+#define AUTO_RUN_RATIO (1.0 / 32)
+
+// Sampled distant pairs inverted at most this fraction, or at least 1 minus it, means nearly sorted or
+// nearly reversed. Then runs starting at up to AUTO_PRESORTED_RUN_RATIO of the items still go to tim_sort.
+#define AUTO_INVERSION_RATIO (1.0 / 64)
+#define AUTO_PRESORTED_RUN_RATIO (1.0 / 4)
+
+// Duplicates in the sample at least this fraction means few distinct keys.
+#define AUTO_DUPLICATE_RATIO 0.75
+
+// Inputs at least this large go to radix_sort.
+#define AUTO_RADIX_MIN 2048
+
+const char* const strategy_names[STRATEGY_COUNT] = {
+    "insertion", "run merge", "counting", "radix", "introsort",
+};
+
+void profile_input(const item_t arr[], int n, struct sort_profile* profile)
+{
+    memset(profile, 0, sizeof(*profile));
+    profile->n = n;
+    if (n <= AUTO_INSERTION_MAX)
+    {
+        profile->strategy = STRATEGY_INSERTION;
+        return;
+    }
+    if (n < AUTO_PROFILE_MIN)
+    {
+        profile->strategy = STRATEGY_INTROSORT;
+        return;
+    }
+
+    // 等距取样，样本与其后两个元素不单调说明这里有一个升降段的边界
+    int s = n / AUTO_SAMPLE_STEP < AUTO_SAMPLE ? n / AUTO_SAMPLE_STEP : AUTO_SAMPLE;
+    item_t sample[AUTO_SAMPLE];
+    int turns = 0;
+    for (int i = 0; i < s; i++)
+    {
+        int j = (int)((long)i * (n - 3) / s);
+        sample[i] = arr[j];
+        bool up = arr[j] <= arr[j + 1] && arr[j + 1] <= arr[j + 2];
+        bool down = arr[j] >= arr[j + 1] && arr[j + 1] >= arr[j + 2];
+        turns += !up && !down;
+    }
+    profile->sample = s;
+    profile->run_ratio = (double)turns / s;
+
+    // 相距半个样本的元素对中逆序的比例
+    int inversions = 0;
+    for (int i = 0; i < s / 2; i++)
+    {
+        inversions += sample[i] > sample[i + s / 2];
+    }
+    profile->inversion_ratio = (double)inversions / (s / 2);
+
+    simd_small_sort(sample, s);
+    int distinct = 1;
+    for (int i = 1; i < s; i++)
+    {
+        distinct += sample[i] != sample[i - 1];
+    }
+    profile->duplicate_ratio = 1 - (double)distinct / s;
+    profile->min = sample[0];
+    profile->max = sample[s - 1];
+
+    bool presorted =
+        profile->inversion_ratio <= AUTO_INVERSION_RATIO || profile->inversion_ratio >= 1 - AUTO_INVERSION_RATIO;
+    if (profile->run_ratio <= AUTO_RUN_RATIO || (presorted && profile->run_ratio <= AUTO_PRESORTED_RUN_RATIO))
+    {
+        profile->strategy = STRATEGY_RUN_MERGE;
+    }
+    else if ((long)profile->max - profile->min < n)
+    {
+        profile->strategy = STRATEGY_COUNTING;
+    }
+    else if (profile->duplicate_ratio >= AUTO_DUPLICATE_RATIO || presorted)
+    {
+        profile->strategy = STRATEGY_INTROSORT;
+    }
+    else if (n >= AUTO_RADIX_MIN)
+    {
+        profile->strategy = STRATEGY_RADIX;
+    }
+    else
+    {
+        profile->strategy = STRATEGY_INTROSORT;
+    }
+}
+
+void auto_sort_ws(item_t arr[], int n, sort_workspace_t* ws)
+{
+    struct sort_profile profile;
+    profile_input(arr, n, &profile);
+
+#ifdef AUTO_SORT_DEBUG
+    fprintf(stderr,
+            "auto_sort: n=%d sample=%d runs=%.3f inversions=%.3f duplicates=%.3f range=[%d, %d] -> %s\n", n,
+            profile.sample, profile.run_ratio, profile.inversion_ratio, profile.duplicate_ratio, profile.min,
+            profile.max, strategy_names[profile.strategy]);
+#endif
+
+    switch (profile.strategy)
+    {
+        case STRATEGY_INSERTION:
+            insertion_sort(arr, n);
+            break;
+        case STRATEGY_RUN_MERGE:
+            tim_sort_ws(arr, n, ws);
+            break;
+        case STRATEGY_COUNTING:
+            counting_sort_ws(arr, n, ws); // 先扫描确切的范围，范围过大时改用 radix_sort
+            break;
+        case STRATEGY_RADIX:
+            radix_sort_ws(arr, n, ws);
+            break;
+        case STRATEGY_INTROSORT:
+        default:
+            quick_sort(arr, n);
+            break;
+    }
+}
+
+void auto_sort(item_t arr[], int n)
+{
+    sort_workspace_t ws;
+    sort_workspace_init(&ws, 0);
+    auto_sort_ws(arr, n, &ws);
+    sort_workspace_free(&ws);
+}
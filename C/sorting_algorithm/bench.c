@@ -0,0 +1,273 @@
+#include "bench.h"
+
+#include <math.h> // ceil
+#include <sys/resource.h>
+#include <time.h>
+
+const char* distribution_names[DIST_COUNT] = {
+    "random", "sorted", "reversed", "few-unique", "sawtooth", "organ-pipe", "zipf", "all-equal"};
+
+// Number of distinct values of the few-unique input.
+#define FEW_UNIQUE_VALUES 16
+
+// Number of ascending teeth of the sawtooth input.
+#define SAWTOOTH_TEETH 16
+
+// Largest rank of the Zipf input (exponent 1).
+#define ZIPF_RANKS 65536
+
+double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static inline uint64_t splitmix64(uint64_t* state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static void generate_zipf(item_t arr[], int n, uint64_t* state)
+{
+    int ranks = n < ZIPF_RANKS ? n : ZIPF_RANKS;
+    double* cdf = (double*)malloc(ranks * sizeof(double));
+    check_pointer(cdf);
+
+    double sum = 0;
+    for (int k = 0; k < ranks; k++)
+    {
+        sum += 1.0 / (k + 1);
+        cdf[k] = sum;
+    }
+
+    // 逆变换采样：二分查找第一个不小于 u 的累计概率
+    for (int i = 0; i < n; i++)
+    {
+        double u = (splitmix64(state) >> 11) * 0x1.0p-53 * sum;
+        int lo = 0, hi = ranks - 1;
+        while (lo < hi)
+        {
+            int mid = (lo + hi) >> 1;
+            if (cdf[mid] < u)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        arr[i] = lo;
+    }
+    free(cdf);
+}
+
+void generate(item_t arr[], int n, enum distribution dist, uint64_t seed)
+{
+    uint64_t state = seed;
+    switch (dist)
+    {
+        case DIST_RANDOM:
+        case DIST_SORTED:
+        case DIST_REVERSED:
+            for (int i = 0; i < n; i++)
+            {
+                arr[i] = (item_t)splitmix64(&state);
+            }
+            if (dist != DIST_RANDOM)
+            {
+                radix_sort(arr, n);
+            }
+            if (dist == DIST_REVERSED)
+            {
+                for (int i = 0, j = n - 1; i < j; i++, j--)
+                {
+                    swap(&arr[i], &arr[j]);
+                }
+            }
+            break;
+        case DIST_FEW_UNIQUE:
+            for (int i = 0; i < n; i++)
+            {
+                arr[i] = (item_t)(splitmix64(&state) % FEW_UNIQUE_VALUES);
+            }
+            break;
+        case DIST_SAWTOOTH:
+        {
+            int tooth = n / SAWTOOTH_TEETH > 0 ? n / SAWTOOTH_TEETH : 1;
+            for (int i = 0; i < n; i++)
+            {
+                arr[i] = i % tooth;
+            }
+            break;
+        }
+        case DIST_ORGAN_PIPE:
+            for (int i = 0; i < n; i++)
+            {
+                arr[i] = i < n / 2 ? i : n - i;
+            }
+            break;
+        case DIST_ZIPF:
+            generate_zipf(arr, n, &state);
+            break;
+        case DIST_ALL_EQUAL:
+        default:
+            for (int i = 0; i < n; i++)
+            {
+                arr[i] = 42;
+            }
+            break;
+    }
+}
+
+checksum_t checksum(const item_t arr[], int n)
+{
+    checksum_t result = {0, 0};
+    for (int i = 0; i < n; i++)
+    {
+        uint64_t state = (uint32_t)arr[i];
+        uint64_t h = splitmix64(&state);
+        result.sum += h;
+        result.xor ^= h * 0xD6E8FEB86659FD93ull;
+    }
+    return result;
+}
+
+bool checksum_equal(checksum_t a, checksum_t b)
+{
+    return a.sum == b.sum && a.xor == b.xor;
+}
+
+bool is_sorted(const item_t arr[], int n)
+{
+    for (int i = 1; i < n; i++)
+    {
+        if (arr[i] < arr[i - 1])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int double_cmp(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+struct stats compute_stats(double samples[], int count)
+{
+    qsort(samples, count, sizeof(double), double_cmp);
+    struct stats s;
+    s.min = samples[0];
+    s.median = count % 2 ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) / 2;
+    s.p90 = samples[(int)ceil(0.9 * count) - 1];
+    return s;
+}
+
+// Linux keeps the peak in VmHWM of /proc/self/status and resets it on a write of "5" to clear_refs.
+void peak_rss_reset(void)
+{
+    FILE* fp = fopen("/proc/self/clear_refs", "w");
+    if (fp)
+    {
+        fputs("5", fp);
+        fclose(fp);
+    }
+}
+
+long peak_rss_kb(void)
+{
+    FILE* fp = fopen("/proc/self/status", "r");
+    if (fp)
+    {
+        char line[256];
+        long kb = -1;
+        while (fgets(line, sizeof(line), fp))
+        {
+            if (sscanf(line, "VmHWM: %ld kB", &kb) == 1)
+            {
+                break;
+            }
+        }
+        fclose(fp);
+        if (kb >= 0)
+        {
+            return kb;
+        }
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+bool bench_open(struct bench_output* out, const char* csv_path, const char* json_path)
+{
+    out->csv = NULL;
+    out->json = NULL;
+    out->records = 0;
+
+    if (csv_path)
+    {
+        out->csv = fopen(csv_path, "w");
+        if (out->csv == NULL)
+        {
+            fprintf(stderr, "ERROR: Can't open %s.\n", csv_path);
+            return false;
+        }
+        fprintf(out->csv, "algorithm,distribution,size,trials,median_ns,p90_ns,min_ns,peak_rss_kb,allocs,verified\n");
+    }
+    if (json_path)
+    {
+        out->json = fopen(json_path, "w");
+        if (out->json == NULL)
+        {
+            fprintf(stderr, "ERROR: Can't open %s.\n", json_path);
+            bench_close(out);
+            return false;
+        }
+        fprintf(out->json, "[");
+    }
+    return true;
+}
+
+void bench_write(struct bench_output* out, const struct bench_record* r)
+{
+    if (out->csv)
+    {
+        fprintf(out->csv, "%s,%s,%d,%d,%.3f,%.3f,%.3f,%ld,%.1f,%s\n", r->algorithm, r->distribution, r->size,
+                r->trials, r->ns_per_item.median, r->ns_per_item.p90, r->ns_per_item.min, r->peak_rss_kb,
+                r->allocs, r->verified ? "true" : "false");
+    }
+    if (out->json)
+    {
+        fprintf(out->json,
+                "%s\n  {\"algorithm\": \"%s\", \"distribution\": \"%s\", \"size\": %d, \"trials\": %d, "
+                "\"median_ns\": %.3f, \"p90_ns\": %.3f, \"min_ns\": %.3f, \"peak_rss_kb\": %ld, "
+                "\"allocs\": %.1f, \"verified\": %s}",
+                out->records ? "," : "", r->algorithm, r->distribution, r->size, r->trials, r->ns_per_item.median,
+                r->ns_per_item.p90, r->ns_per_item.min, r->peak_rss_kb, r->allocs, r->verified ? "true" : "false");
+    }
+    out->records++;
+}
+
+void bench_close(struct bench_output* out)
+{
+    if (out->csv)
+    {
+        fclose(out->csv);
+        out->csv = NULL;
+    }
+    if (out->json)
+    {
+        fprintf(out->json, "\n]\n");
+        fclose(out->json);
+        out->json = NULL;
+    }
+}
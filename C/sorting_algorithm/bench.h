@@ -0,0 +1,77 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "sort.h"
+
+// Input distributions of the benchmark.
+enum distribution
+{
+    DIST_RANDOM,
+    DIST_SORTED,
+    DIST_REVERSED,
+    DIST_FEW_UNIQUE,
+    DIST_SAWTOOTH,
+    DIST_ORGAN_PIPE,
+    DIST_ZIPF,
+    DIST_ALL_EQUAL,
+    DIST_COUNT
+};
+
+extern const char* distribution_names[DIST_COUNT];
+
+// Monotonic wall-clock time in nanoseconds.
+double now_ns(void);
+
+// Fill arr[0, n) with a reproducible input of the given distribution.
+void generate(item_t arr[], int n, enum distribution dist, uint64_t seed);
+
+// Order-independent fingerprint of the items, a correct sort leaves it unchanged.
+typedef struct
+{
+    uint64_t sum;
+    uint64_t xor;
+} checksum_t;
+
+checksum_t checksum(const item_t arr[], int n);
+bool checksum_equal(checksum_t a, checksum_t b);
+bool is_sorted(const item_t arr[], int n);
+
+struct stats
+{
+    double median;
+    double p90;
+    double min;
+};
+
+// Summarize the samples, which get sorted in place.
+struct stats compute_stats(double samples[], int count);
+
+// Peak resident set size in KB since the last reset (since start if the kernel can't reset it).
+void peak_rss_reset(void);
+long peak_rss_kb(void);
+
+struct bench_record
+{
+    const char* algorithm;
+    const char* distribution;
+    int size;
+    int trials;
+    struct stats ns_per_item;
+    long peak_rss_kb;
+    double allocs; // per sort
+    bool verified;
+};
+
+// Optional CSV and JSON sinks for the records, a NULL path disables the format.
+struct bench_output
+{
+    FILE* csv;
+    FILE* json;
+    int records;
+};
+
+bool bench_open(struct bench_output* out, const char* csv_path, const char* json_path);
+void bench_write(struct bench_output* out, const struct bench_record* record);
+void bench_close(struct bench_output* out);
+
+#endif // BENCH_H
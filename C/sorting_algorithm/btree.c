@@ -0,0 +1,372 @@
+#include "btree.h"
+
+// Bulk-loaded leaves are filled to 7/8, leaving room for inserts before they split.
+#define BTREE_LEAF_FILL (BTREE_LEAF_SIZE * 7 / 8)
+
+// Batches of at least 1 / BTREE_REBUILD_RATIO of the tree are merged with all its items and rebuilt.
+#define BTREE_REBUILD_RATIO 8
+
+// Nodes start on a cache line.
+#define BTREE_ALIGN 64
+
+static void free_node(void* node, int height)
+{
+    if (height > 0)
+    {
+        btree_inner_t* inner = (btree_inner_t*)node;
+        for (int i = 0; i < inner->size; i++)
+        {
+            free_node(inner->child[i], height - 1);
+        }
+    }
+    free(node);
+}
+
+static void clear(btree_t* tree)
+{
+    if (tree->root)
+    {
+        free_node(tree->root, tree->height);
+    }
+    tree->root = NULL;
+    tree->height = 0;
+    tree->size = 0;
+    tree->first = NULL;
+}
+
+void btree_init(btree_t* tree)
+{
+    tree->root = NULL;
+    tree->height = 0;
+    tree->size = 0;
+    tree->first = NULL;
+    sort_workspace_init(&tree->ws, 0);
+}
+
+void btree_free(btree_t* tree)
+{
+    clear(tree);
+    sort_workspace_free(&tree->ws);
+}
+
+// Build the tree on sorted arr[0, n) bottom up, the tree must be empty.
+static void build_sorted(btree_t* tree, const item_t arr[], long n)
+{
+    if (n == 0)
+    {
+        return;
+    }
+
+    // 叶子平均分配元素，每层记录结点与其最小元素
+    long count = (n + BTREE_LEAF_FILL - 1) / BTREE_LEAF_FILL;
+    void** nodes = (void**)sort_malloc(count * sizeof(void*));
+    item_t* mins = (item_t*)sort_malloc(count * sizeof(item_t));
+    btree_leaf_t* prev = NULL;
+    for (long i = 0; i < count; i++)
+    {
+        long begin = n * i / count, end = n * (i + 1) / count;
+        btree_leaf_t* leaf = (btree_leaf_t*)sort_aligned_malloc(BTREE_ALIGN, sizeof(btree_leaf_t));
+        leaf->size = (int)(end - begin);
+        leaf->next = NULL;
+        memcpy(leaf->keys, arr + begin, leaf->size * sizeof(item_t));
+        if (prev)
+        {
+            prev->next = leaf;
+        }
+        else
+        {
+            tree->first = leaf;
+        }
+        prev = leaf;
+        nodes[i] = leaf;
+        mins[i] = arr[begin];
+    }
+
+    // 逐层向上，父结点 p 只覆盖已经读过的位置
+    int height = 0;
+    while (count > 1)
+    {
+        long parents = (count + BTREE_FANOUT - 1) / BTREE_FANOUT;
+        for (long p = 0; p < parents; p++)
+        {
+            long begin = count * p / parents, end = count * (p + 1) / parents;
+            btree_inner_t* inner = (btree_inner_t*)sort_aligned_malloc(BTREE_ALIGN, sizeof(btree_inner_t));
+            inner->size = (int)(end - begin);
+            for (int i = 0; i < inner->size; i++)
+            {
+                inner->child[i] = nodes[begin + i];
+                if (i > 0)
+                {
+                    inner->keys[i - 1] = mins[begin + i];
+                }
+            }
+            nodes[p] = inner;
+            mins[p] = mins[begin];
+        }
+        count = parents;
+        height++;
+    }
+
+    tree->root = nodes[0];
+    tree->height = height;
+    tree->size = n;
+    free(nodes);
+    free(mins);
+}
+
+void btree_build(btree_t* tree, item_t arr[], int n)
+{
+    clear(tree);
+    // 排序整个数组的辅助空间用完即释放，不随树一直占着
+    sort_workspace_t ws;
+    sort_workspace_init(&ws, 0);
+    auto_sort_ws(arr, n, &ws);
+    sort_workspace_free(&ws);
+    build_sorted(tree, arr, n);
+}
+
+// Insert x under `node`. When the node splits, return true with the new right node and its separator.
+static bool insert_into(void* node, int height, item_t x, item_t* split_key, void** split_node)
+{
+    if (height == 0)
+    {
+        btree_leaf_t* leaf = (btree_leaf_t*)node;
+        int pos = search_bound(leaf->keys, leaf->size, x, true);
+        if (leaf->size < BTREE_LEAF_SIZE)
+        {
+            memmove(leaf->keys + pos + 1, leaf->keys + pos, (leaf->size - pos) * sizeof(item_t));
+            leaf->keys[pos] = x;
+            leaf->size++;
+            return false;
+        }
+
+        // 满叶对半分裂，再插入到所在的一半
+        btree_leaf_t* right = (btree_leaf_t*)sort_aligned_malloc(BTREE_ALIGN, sizeof(btree_leaf_t));
+        int half = BTREE_LEAF_SIZE / 2;
+        right->size = BTREE_LEAF_SIZE - half;
+        memcpy(right->keys, leaf->keys + half, right->size * sizeof(item_t));
+        right->next = leaf->next;
+        leaf->next = right;
+        leaf->size = half;
+        btree_leaf_t* target = pos <= half ? leaf : right;
+        pos = pos <= half ? pos : pos - half;
+        memmove(target->keys + pos + 1, target->keys + pos, (target->size - pos) * sizeof(item_t));
+        target->keys[pos] = x;
+        target->size++;
+        *split_key = right->keys[0];
+        *split_node = right;
+        return true;
+    }
+
+    btree_inner_t* inner = (btree_inner_t*)node;
+    int i = search_bound(inner->keys, inner->size - 1, x, true);
+    item_t key;
+    void* child;
+    if (!insert_into(inner->child[i], height - 1, x, &key, &child))
+    {
+        return false;
+    }
+
+    // 新的右兄弟插在 child[i] 之后
+    item_t keys[BTREE_FANOUT];
+    void* children[BTREE_FANOUT + 1];
+    int size = inner->size;
+    memcpy(keys, inner->keys, i * sizeof(item_t));
+    keys[i] = key;
+    memcpy(keys + i + 1, inner->keys + i, (size - 1 - i) * sizeof(item_t));
+    memcpy(children, inner->child, (i + 1) * sizeof(void*));
+    children[i + 1] = child;
+    memcpy(children + i + 2, inner->child + i + 1, (size - 1 - i) * sizeof(void*));
+    size++;
+
+    if (size <= BTREE_FANOUT)
+    {
+        inner->size = size;
+        memcpy(inner->keys, keys, (size - 1) * sizeof(item_t));
+        memcpy(inner->child, children, size * sizeof(void*));
+        return false;
+    }
+
+    // 左边留 half 个孩子，keys[half - 1] 上移作为分隔
+    int half = size / 2;
+    btree_inner_t* right = (btree_inner_t*)sort_aligned_malloc(BTREE_ALIGN, sizeof(btree_inner_t));
+    inner->size = half;
+    memcpy(inner->keys, keys, (half - 1) * sizeof(item_t));
+    memcpy(inner->child, children, half * sizeof(void*));
+    right->size = size - half;
+    memcpy(right->keys, keys + half, (right->size - 1) * sizeof(item_t));
+    memcpy(right->child, children + half, right->size * sizeof(void*));
+    *split_key = keys[half - 1];
+    *split_node = right;
+    return true;
+}
+
+void btree_insert(btree_t* tree, item_t x)
+{
+    if (tree->root == NULL)
+    {
+        build_sorted(tree, &x, 1);
+        return;
+    }
+
+    item_t key;
+    void* right;
+    if (insert_into(tree->root, tree->height, x, &key, &right))
+    {
+        btree_inner_t* root = (btree_inner_t*)sort_aligned_malloc(BTREE_ALIGN, sizeof(btree_inner_t));
+        root->size = 2;
+        root->keys[0] = key;
+        root->child[0] = tree->root;
+        root->child[1] = right;
+        tree->root = root;
+        tree->height++;
+    }
+    tree->size++;
+}
+
+// Leaf an insert of x goes to. Items less than *bound, or all if !*bounded, go to the same leaf.
+static btree_leaf_t* find_leaf(const btree_t* tree, item_t x, item_t* bound, bool* bounded)
+{
+    void* node = tree->root;
+    *bounded = false;
+    for (int h = tree->height; h > 0; h--)
+    {
+        btree_inner_t* inner = (btree_inner_t*)node;
+        int i = search_bound(inner->keys, inner->size - 1, x, true);
+        if (i < inner->size - 1)
+        {
+            *bound = inner->keys[i];
+            *bounded = true;
+        }
+        node = inner->child[i];
+    }
+    return (btree_leaf_t*)node;
+}
+
+// Merge the whole tree with sorted batch[0, n) and build it again.
+static void rebuild(btree_t* tree, const item_t batch[], int n, sort_workspace_t* ws)
+{
+    long total = tree->size + n;
+    item_t* merged = (item_t*)sort_workspace_reserve(ws, total * sizeof(item_t));
+    const btree_leaf_t* leaf = tree->first;
+    int pos = 0, j = 0;
+    for (long k = 0; k < total; k++)
+    {
+        // 相等时先取树中已有的元素
+        if (j == n || (leaf && leaf->keys[pos] <= batch[j]))
+        {
+            merged[k] = leaf->keys[pos];
+            if (++pos == leaf->size)
+            {
+                leaf = leaf->next;
+                pos = 0;
+            }
+        }
+        else
+        {
+            merged[k] = batch[j++];
+        }
+    }
+    clear(tree);
+    build_sorted(tree, merged, total);
+}
+
+void btree_insert_batch(btree_t* tree, item_t batch[], int n)
+{
+    if (n <= 0)
+    {
+        return;
+    }
+    if ((long)n * BTREE_REBUILD_RATIO >= tree->size)
+    {
+        // 重建要与整棵树一样大的缓冲，用临时工作区，tree->ws 只留给小批量
+        sort_workspace_t ws;
+        sort_workspace_init(&ws, 0);
+        auto_sort_ws(batch, n, &ws);
+        rebuild(tree, batch, n, &ws);
+        sort_workspace_free(&ws);
+        return;
+    }
+    auto_sort_ws(batch, n, &tree->ws);
+
+    for (int i = 0; i < n;)
+    {
+        item_t bound;
+        bool bounded;
+        btree_leaf_t* leaf = find_leaf(tree, batch[i], &bound, &bounded);
+        int room = BTREE_LEAF_SIZE - leaf->size;
+        if (room == 0)
+        {
+            btree_insert(tree, batch[i++]);
+            continue;
+        }
+
+        // 同一叶子的一组元素从后向前归并进去，相等时新元素在后
+        int m = 0;
+        while (m < room && i + m < n && (!bounded || batch[i + m] < bound))
+        {
+            m++;
+        }
+        const item_t* group = batch + i;
+        int a = leaf->size - 1, b = m - 1, k = leaf->size + m - 1;
+        while (b >= 0)
+        {
+            leaf->keys[k--] = a >= 0 && leaf->keys[a] > group[b] ? leaf->keys[a--] : group[b--];
+        }
+        leaf->size += m;
+        tree->size += m;
+        i += m;
+    }
+}
+
+btree_iter_t btree_begin(const btree_t* tree)
+{
+    btree_iter_t it = {tree->first, 0};
+    return it;
+}
+
+btree_iter_t btree_lower_bound(const btree_t* tree, item_t x)
+{
+    btree_iter_t it = {NULL, 0};
+    if (tree->root == NULL)
+    {
+        return it;
+    }
+    void* node = tree->root;
+    for (int h = tree->height; h > 0; h--)
+    {
+        btree_inner_t* inner = (btree_inner_t*)node;
+        node = inner->child[search_bound(inner->keys, inner->size - 1, x, false)];
+    }
+
+    // 等于分隔键的元素可能在左边子树的末尾，找不到时就是下一片叶子的开头
+    it.leaf = (const btree_leaf_t*)node;
+    it.pos = search_bound(it.leaf->keys, it.leaf->size, x, false);
+    if (it.pos == it.leaf->size)
+    {
+        it.leaf = it.leaf->next;
+        it.pos = 0;
+    }
+    return it;
+}
+
+int btree_range(const btree_t* tree, item_t lo, item_t hi, item_t out[], int max)
+{
+    btree_iter_t it = btree_lower_bound(tree, lo);
+    int count = 0;
+    for (const btree_leaf_t* leaf = it.leaf; leaf && count < max; leaf = leaf->next)
+    {
+        // 整片叶子都在范围内时整块复制
+        int begin = leaf == it.leaf ? it.pos : 0;
+        int end = leaf->keys[leaf->size - 1] < hi ? leaf->size : search_bound(leaf->keys, leaf->size, hi, false);
+        end = end > begin ? end : begin;
+        end = end - begin < max - count ? end : begin + max - count;
+        memcpy(out + count, leaf->keys + begin, (end - begin) * sizeof(item_t));
+        count += end - begin;
+        if (end < leaf->size)
+        {
+            break;
+        }
+    }
+    return count;
+}
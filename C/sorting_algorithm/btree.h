@@ -0,0 +1,89 @@
+#ifndef BTREE_H
+#define BTREE_H
+
+#include "sort.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Ordered multiset of items kept in a B+tree with fat leaves, see btree.c. Leaves hold sorted
+// runs of up to BTREE_LEAF_SIZE items and are linked in order, so a range is read like an array.
+// Inner nodes only route: child[i] <= keys[i] <= child[i + 1]. There is no deletion.
+
+// Items per leaf and children per inner node, both a few KB so a node is a handful of cache lines.
+#define BTREE_LEAF_SIZE 256
+#define BTREE_FANOUT 64
+
+typedef struct btree_leaf
+{
+    int size;
+    struct btree_leaf* next;
+    item_t keys[BTREE_LEAF_SIZE];
+} btree_leaf_t;
+
+typedef struct btree_inner
+{
+    int size; // children
+    item_t keys[BTREE_FANOUT - 1];
+    void* child[BTREE_FANOUT];
+} btree_inner_t;
+
+typedef struct
+{
+    void* root; // a leaf when height is 0, NULL when empty
+    int height;
+    long size;
+    btree_leaf_t* first;
+    sort_workspace_t ws; // for sorting the batches merged into the leaves, below 1 / BTREE_REBUILD_RATIO of the tree
+} btree_t;
+
+// Position of an item, or the end when `leaf` is NULL.
+typedef struct
+{
+    const btree_leaf_t* leaf;
+    int pos;
+} btree_iter_t;
+
+void btree_init(btree_t* tree);
+void btree_free(btree_t* tree);
+
+// Replace the content by arr[0, n), which is sorted in place with auto_sort().
+void btree_build(btree_t* tree, item_t arr[], int n);
+
+void btree_insert(btree_t* tree, item_t x);
+
+// Insert batch[0, n), which is sorted in place, then merged into the leaves it falls in. A batch of
+// at least 1 / BTREE_REBUILD_RATIO of the tree rebuilds it from the merged items instead.
+void btree_insert_batch(btree_t* tree, item_t batch[], int n);
+
+btree_iter_t btree_begin(const btree_t* tree);
+btree_iter_t btree_lower_bound(const btree_t* tree, item_t x); // first item not less than x
+
+// Copy the items of [lo, hi) in order into out[], at most `max` of them, return how many.
+int btree_range(const btree_t* tree, item_t lo, item_t hi, item_t out[], int max);
+
+static inline bool btree_iter_valid(btree_iter_t it)
+{
+    return it.leaf != NULL;
+}
+
+static inline item_t btree_iter_get(btree_iter_t it)
+{
+    return it.leaf->keys[it.pos];
+}
+
+static inline void btree_iter_next(btree_iter_t* it)
+{
+    if (++it->pos == it->leaf->size)
+    {
+        it->leaf = it->leaf->next;
+        it->pos = 0;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BTREE_H
@@ -0,0 +1,109 @@
+// Compare the B+tree of btree.c with std::multiset on the workload of btree_test() in main.c.
+// Build with `xmake build btree_bench`, or by hand:
+//
+//   gcc -O2 -mavx2 -pthread -c $(ls *.c | grep -v main.c)
+//   g++ -std=c++20 -O2 -mavx2 -pthread btree_bench.cpp *.o -o btree_bench -lm
+//   ./btree_bench [size]
+
+#include "btree.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <vector>
+
+// Batches inserted after the initial load, each of n / 1000 items.
+constexpr int BATCHES = 20;
+
+static double now_ms()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char* argv[])
+{
+    int n = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    int batch = n / 1000 > 0 ? n / 1000 : 1;
+    std::mt19937 rng(20240607);
+    std::vector<item_t> input(n + BATCHES * batch), queries(n);
+    for (item_t& x : input)
+    {
+        x = (item_t)rng();
+    }
+    for (item_t& x : queries)
+    {
+        x = (item_t)rng();
+    }
+
+    printf("%d random items kept ordered under %d batches of %d inserts, then %d lookups\n", n, BATCHES, batch, n);
+    printf("%-16s%10s%12s%12s%10s%18s\n", "container", "load(ms)", "insert(ms)", "lookup(ns)", "scan(ms)", "checksum");
+
+    // std::multiset，重复的键也要保留
+    {
+        double start = now_ms();
+        std::multiset<item_t> set(input.begin(), input.begin() + n);
+        double load = now_ms() - start;
+
+        start = now_ms();
+        for (int b = 0; b < BATCHES; b++)
+        {
+            set.insert(input.begin() + n + b * batch, input.begin() + n + (b + 1) * batch);
+        }
+        double insert = now_ms() - start;
+
+        long found = 0;
+        start = now_ms();
+        for (item_t q : queries)
+        {
+            auto it = set.lower_bound(q);
+            found += it != set.end() ? *it : 0;
+        }
+        double lookup = (now_ms() - start) * 1e6 / n;
+
+        start = now_ms();
+        for (item_t x : set)
+        {
+            found += x;
+        }
+        double scan = now_ms() - start;
+        printf("%-16s%10.3f%12.3f%12.2f%10.3f%18ld\n", "std::multiset", load, insert, lookup, scan, found);
+    }
+
+    {
+        btree_t tree;
+        btree_init(&tree);
+        std::vector<item_t> work(input.begin(), input.begin() + n);
+        double start = now_ms();
+        btree_build(&tree, work.data(), n);
+        double load = now_ms() - start;
+
+        start = now_ms();
+        for (int b = 0; b < BATCHES; b++)
+        {
+            work.assign(input.begin() + n + b * batch, input.begin() + n + (b + 1) * batch);
+            btree_insert_batch(&tree, work.data(), batch);
+        }
+        double insert = now_ms() - start;
+
+        long found = 0;
+        start = now_ms();
+        for (item_t q : queries)
+        {
+            btree_iter_t it = btree_lower_bound(&tree, q);
+            found += btree_iter_valid(it) ? btree_iter_get(it) : 0;
+        }
+        double lookup = (now_ms() - start) * 1e6 / n;
+
+        start = now_ms();
+        for (btree_iter_t it = btree_begin(&tree); btree_iter_valid(it); btree_iter_next(&it))
+        {
+            found += btree_iter_get(it);
+        }
+        double scan = now_ms() - start;
+        printf("%-16s%10.3f%12.3f%12.2f%10.3f%18ld\n", "btree", load, insert, lookup, scan, found);
+        btree_free(&tree);
+    }
+    return 0;
+}
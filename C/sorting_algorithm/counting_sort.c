@@ -0,0 +1,250 @@
+#include "sort.h"
+#include "thread_pool.h"
+
+// Counting sorts for keys in a small range, found by a min/max pre-scan. Sorting is O(n + range)
+// with one counter per key value, so a range larger than COUNTING_RANGE_FACTOR * n goes to
+// another sort instead.
+
+#define COUNTING_RANGE_FACTOR 2
+
+// Inputs smaller than this are sorted serially.
+#define COUNTING_SORT_THRESHOLD 65536
+
+static inline void min_max(const item_t arr[], int n, item_t* min, item_t* max)
+{
+    item_t lo = arr[0], hi = arr[0];
+    for (int i = 1; i < n; i++)
+    {
+        lo = arr[i] < lo ? arr[i] : lo;
+        hi = arr[i] > hi ? arr[i] : hi;
+    }
+    *min = lo;
+    *max = hi;
+}
+
+static inline bool small_range(long range, int n)
+{
+    return range <= (long)COUNTING_RANGE_FACTOR * n;
+}
+
+void counting_sort_ws(item_t arr[], int n, sort_workspace_t* ws)
+{
+    if (n < 2)
+    {
+        return;
+    }
+    item_t min, max;
+    min_max(arr, n, &min, &max);
+    long range = (long)max - min + 1;
+    if (!small_range(range, n))
+    {
+        radix_sort_ws(arr, n, ws);
+        return;
+    }
+
+    int* count = (int*)sort_workspace_reserve(ws, range * sizeof(int));
+    memset(count, 0, range * sizeof(int));
+    for (int i = 0; i < n; i++)
+    {
+        count[arr[i] - min]++;
+    }
+    for (long v = 0, k = 0; v < range; v++)
+    {
+        for (int c = count[v]; c > 0; c--)
+        {
+            arr[k++] = (item_t)(min + v);
+        }
+    }
+}
+
+void counting_sort(item_t arr[], int n)
+{
+    sort_workspace_t ws;
+    sort_workspace_init(&ws, 0);
+    counting_sort_ws(arr, n, &ws);
+    sort_workspace_free(&ws);
+}
+
+bool counting_sort_records_ws(const void* records, int n, size_t size, size_t offset, void* out,
+                              sort_workspace_t* ws)
+{
+    const char* in = (const char*)records;
+    if (n < 1)
+    {
+        return true;
+    }
+
+    // 键可能未对齐，用 memcpy 读取
+    item_t min, max, key;
+    memcpy(&min, in + offset, sizeof(item_t));
+    max = min;
+    for (int i = 1; i < n; i++)
+    {
+        memcpy(&key, in + i * size + offset, sizeof(item_t));
+        min = key < min ? key : min;
+        max = key > max ? key : max;
+    }
+    long range = (long)max - min + 1;
+    if (!small_range(range, n))
+    {
+        return false;
+    }
+
+    // 直方图的前缀和就是每个键的第一个写入位置，按输入顺序写出保证稳定
+    int* next = (int*)sort_workspace_reserve(ws, range * sizeof(int));
+    memset(next, 0, range * sizeof(int));
+    for (int i = 0; i < n; i++)
+    {
+        memcpy(&key, in + i * size + offset, sizeof(item_t));
+        next[key - min]++;
+    }
+    int sum = 0;
+    for (long v = 0; v < range; v++)
+    {
+        int c = next[v];
+        next[v] = sum;
+        sum += c;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        memcpy(&key, in + i * size + offset, sizeof(item_t));
+        memcpy((char*)out + (size_t)next[key - min]++ * size, in + i * size, size);
+    }
+    return true;
+}
+
+bool counting_sort_records(const void* records, int n, size_t size, size_t offset, void* out)
+{
+    sort_workspace_t ws;
+    sort_workspace_init(&ws, 0);
+    bool sorted = counting_sort_records_ws(records, n, size, offset, out, &ws);
+    sort_workspace_free(&ws);
+    return sorted;
+}
+
+struct counting_sort
+{
+    item_t* arr;
+    int n;
+    int threads;
+    item_t min;
+    long range;
+    item_t* block_min; // per block
+    item_t* block_max;
+    int* counts;       // counts[block * range + value], merged into counts[0, range)
+    long* slice_start; // first output position of every value slice
+};
+
+static inline int block_begin(const struct counting_sort* cs, int block)
+{
+    return (int)((long)cs->n * block / cs->threads);
+}
+
+static inline long slice_begin(const struct counting_sort* cs, int slice)
+{
+    return cs->range * slice / cs->threads;
+}
+
+static void scan_block(void* context, int block)
+{
+    struct counting_sort* cs = (struct counting_sort*)context;
+    int begin = block_begin(cs, block);
+    min_max(cs->arr + begin, block_begin(cs, block + 1) - begin, &cs->block_min[block], &cs->block_max[block]);
+}
+
+static void count_block(void* context, int block)
+{
+    struct counting_sort* cs = (struct counting_sort*)context;
+    int* count = cs->counts + block * cs->range;
+    for (int i = block_begin(cs, block), end = block_begin(cs, block + 1); i < end; i++)
+    {
+        count[cs->arr[i] - cs->min]++;
+    }
+}
+
+// Add the histograms of all the blocks into the first one, over a slice of the values.
+static void merge_slice(void* context, int slice)
+{
+    struct counting_sort* cs = (struct counting_sort*)context;
+    long total = 0;
+    for (long v = slice_begin(cs, slice), end = slice_begin(cs, slice + 1); v < end; v++)
+    {
+        int c = cs->counts[v];
+        for (int block = 1; block < cs->threads; block++)
+        {
+            c += cs->counts[block * cs->range + v];
+        }
+        cs->counts[v] = c;
+        total += c;
+    }
+    cs->slice_start[slice + 1] = total;
+}
+
+static void write_slice(void* context, int slice)
+{
+    struct counting_sort* cs = (struct counting_sort*)context;
+    long k = cs->slice_start[slice];
+    for (long v = slice_begin(cs, slice), end = slice_begin(cs, slice + 1); v < end; v++)
+    {
+        for (int c = cs->counts[v]; c > 0; c--)
+        {
+            cs->arr[k++] = (item_t)(cs->min + v);
+        }
+    }
+}
+
+void parallel_counting_sort(item_t arr[], int n, int threads)
+{
+    if (threads <= 0)
+    {
+        threads = cpu_count();
+    }
+    if (threads == 1 || n <= COUNTING_SORT_THRESHOLD)
+    {
+        counting_sort(arr, n);
+        return;
+    }
+
+    struct counting_sort cs = {arr, n, threads};
+    cs.block_min = (item_t*)sort_malloc(2 * threads * sizeof(item_t));
+    cs.block_max = cs.block_min + threads;
+    pool_for(threads, threads, scan_block, &cs);
+    item_t min = cs.block_min[0], max = cs.block_max[0];
+    for (int block = 1; block < threads; block++)
+    {
+        min = cs.block_min[block] < min ? cs.block_min[block] : min;
+        max = cs.block_max[block] > max ? cs.block_max[block] : max;
+    }
+    free(cs.block_min);
+    cs.min = min;
+    cs.range = (long)max - min + 1;
+
+    // 每个线程一份直方图，总大小也要受范围限制
+    if (!small_range(cs.range * threads, n))
+    {
+        if (small_range(cs.range, n))
+        {
+            counting_sort(arr, n);
+        }
+        else
+        {
+            parallel_sample_sort(arr, n, threads);
+        }
+        return;
+    }
+
+    cs.counts = (int*)sort_malloc(threads * cs.range * sizeof(int));
+    cs.slice_start = (long*)sort_malloc((threads + 1) * sizeof(long));
+    memset(cs.counts, 0, threads * cs.range * sizeof(int));
+    pool_for(threads, threads, count_block, &cs);
+    pool_for(threads, threads, merge_slice, &cs);
+    cs.slice_start[0] = 0;
+    for (int slice = 0; slice < threads; slice++)
+    {
+        cs.slice_start[slice + 1] += cs.slice_start[slice];
+    }
+    pool_for(threads, threads, write_slice, &cs);
+
+    free(cs.counts);
+    free(cs.slice_start);
+}
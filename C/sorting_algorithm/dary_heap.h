@@ -0,0 +1,76 @@
+#ifndef DARY_HEAP_H
+#define DARY_HEAP_H
+
+#include "sort.h"
+
+// Building blocks of a d-ary max-heap of item_t, node i has the children [d * i + 1, d * i + d].
+// D is meant to be a compile-time constant (4 or 8) so that the loops unroll.
+
+#define DARY_CACHE_LINE 64
+
+static inline void dary_prefetch_grandchildren(const item_t heap[], int node, int n, const int D)
+{
+#if defined(__GNUC__)
+    int first = D * (D * node + 1) + 1;
+    for (int i = 0; i < D * D && first + i < n; i += DARY_CACHE_LINE / sizeof(item_t))
+    {
+        __builtin_prefetch(&heap[first + i]);
+    }
+#endif
+}
+
+// Index of the largest of the D children starting at first.
+static inline int dary_max_child(const item_t heap[], int first, const int D)
+{
+    int child = first;
+    item_t best = heap[first];
+    for (int c = first + 1; c < first + D; c++)
+    {
+        child = heap[c] > best ? c : child;
+        best = heap[c] > best ? heap[c] : best;
+    }
+    return child;
+}
+
+// Put tmp in the subheap rooted at r of the max-heap heap[0, n), whose slot r is free.
+// Floyd's bottom-up sift-down: the hole goes down to a leaf along the largest children without
+// comparing against tmp, which then climbs back up the few levels it needs.
+static inline void dary_sift_down(item_t heap[], int r, int n, item_t tmp, const int D)
+{
+    // 空位沿最大的孩子一直下沉到叶子
+    int hole = r;
+    for (int first = D * hole + 1; first < n; first = D * hole + 1)
+    {
+        dary_prefetch_grandchildren(heap, hole, n, D);
+        int child;
+        if (first + D <= n)
+        {
+            child = dary_max_child(heap, first, D);
+        }
+        else
+        {
+            child = first;
+            for (int c = first + 1; c < n; c++)
+            {
+                child = heap[c] > heap[child] ? c : child;
+            }
+        }
+        heap[hole] = heap[child];
+        hole = child;
+    }
+
+    // 再把 tmp 从叶子上浮到合适的位置
+    while (hole > r)
+    {
+        int parent = (hole - 1) / D;
+        if (heap[parent] >= tmp)
+        {
+            break;
+        }
+        heap[hole] = heap[parent];
+        hole = parent;
+    }
+    heap[hole] = tmp;
+}
+
+#endif // DARY_HEAP_H
@@ -0,0 +1,61 @@
+#include "dary_heap.h"
+#include "sort.h"
+
+#include <stdint.h>
+
+// Heap sort on a d-ary max-heap (d = 4 or 8). The heap is placed so that the d children of a node
+// start on a multiple of d items and share one cache line, which halves (d = 4) or thirds (d = 8)
+// the depth of the binary heap. Sift-down is Floyd's bottom-up variant, see dary_heap.h.
+
+// Inputs smaller than this are sorted by insertion sort.
+#define DARY_HEAP_THRESHOLD 16
+
+static inline void dary_heap_sort(item_t arr[], int n, const int D)
+{
+    if (n < DARY_HEAP_THRESHOLD)
+    {
+        insertion_sort(arr, n);
+        return;
+    }
+
+    // 跳过开头 shift 个元素，使每组孩子 heap[D * k + 1, D * k + D] 按 D 个元素对齐
+    int group = D * sizeof(item_t);
+    int shift = (int)((group - ((uintptr_t)(arr + 1) % group)) % group / sizeof(item_t));
+    item_t* heap = arr + shift;
+    int m = n - shift;
+
+    for (int i = (m - 2) / D; i >= 0; i--)
+    {
+        dary_sift_down(heap, i, m, heap[i], D);
+    }
+    for (int i = m - 1; i > 0; i--)
+    {
+        item_t tmp = heap[i];
+        heap[i] = heap[0];
+        dary_sift_down(heap, 0, i, tmp, D);
+    }
+
+    // 跳过的前缀排好序后与堆排序的结果归并
+    if (shift > 0)
+    {
+        item_t prefix[8];
+        insertion_sort(arr, shift);
+        memcpy(prefix, arr, shift * sizeof(item_t));
+        int i = 0, j = shift, k = 0;
+        while (i < shift && j < n)
+        {
+            arr[k++] = arr[j] < prefix[i] ? arr[j++] : prefix[i++];
+        }
+        memcpy(arr + k, prefix + i, (shift - i) * sizeof(item_t));
+    }
+}
+
+void heap4_sort(item_t arr[], int n)
+{
+    dary_heap_sort(arr, n, 4);
+}
+
+void heap8_sort(item_t arr[], int n)
+{
+    dary_heap_sort(arr, n, 8);
+}
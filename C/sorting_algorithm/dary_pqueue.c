@@ -0,0 +1,80 @@
+#include "pqueue.h"
+
+static inline void place(dary_pq_t* q, int i, pq_entry_t e)
+{
+    q->heap[i] = e;
+    q->pos[e.id] = i;
+}
+
+// Put e in the free slot i and move it up to where its parent is not larger.
+static inline void sift_up(dary_pq_t* q, int i, pq_entry_t e)
+{
+    while (i > 0)
+    {
+        int parent = (i - 1) / DARY_PQ_D;
+        if (q->heap[parent].priority <= e.priority)
+        {
+            break;
+        }
+        place(q, i, q->heap[parent]);
+        i = parent;
+    }
+    place(q, i, e);
+}
+
+// Put e in the free root slot, bottom up as dary_sift_down() of dary_heap.h does: the hole goes down
+// along the smallest children to a leaf, then e climbs back up, usually no more than a level.
+static inline void sift_down(dary_pq_t* q, pq_entry_t e)
+{
+    int hole = 0, n = q->size;
+    for (int first = DARY_PQ_D * hole + 1; first < n; first = DARY_PQ_D * hole + 1)
+    {
+        int child = first;
+        int end = first + DARY_PQ_D < n ? first + DARY_PQ_D : n;
+        for (int c = first + 1; c < end; c++)
+        {
+            child = q->heap[c].priority < q->heap[child].priority ? c : child;
+        }
+        place(q, hole, q->heap[child]);
+        hole = child;
+    }
+    sift_up(q, hole, e);
+}
+
+void dary_pq_init(dary_pq_t* q, int capacity)
+{
+    q->heap = (pq_entry_t*)sort_malloc(capacity * sizeof(pq_entry_t));
+    q->pos = (int*)sort_malloc(capacity * sizeof(int));
+    memset(q->pos, -1, capacity * sizeof(int));
+    q->size = 0;
+}
+
+void dary_pq_free(dary_pq_t* q)
+{
+    free(q->heap);
+    free(q->pos);
+}
+
+void dary_pq_push(dary_pq_t* q, int id, uint32_t priority)
+{
+    pq_entry_t e = {priority, id};
+    sift_up(q, q->size++, e);
+}
+
+int dary_pq_pop(dary_pq_t* q, uint32_t* priority)
+{
+    pq_entry_t top = q->heap[0];
+    q->pos[top.id] = -1;
+    *priority = top.priority;
+    if (--q->size > 0)
+    {
+        sift_down(q, q->heap[q->size]);
+    }
+    return top.id;
+}
+
+void dary_pq_decrease(dary_pq_t* q, int id, uint32_t priority)
+{
+    pq_entry_t e = {priority, id};
+    sift_up(q, q->pos[id], e);
+}
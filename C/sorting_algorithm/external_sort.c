@@ -0,0 +1,448 @@
+#include "loser_tree.h"
+#include "sort.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h> // mkstemp, unlink
+
+// External merge sort of a binary file of item_t: sorted runs of half the memory budget are spilled
+// to temp files, then merged k ways through a loser tree. A background thread does all the reads
+// and writes of the merge, so the next block of every run is loaded while the current one is merged.
+
+// Largest number of runs merged in one pass, more runs take several passes.
+#define MAX_FAN_IN 256
+
+// Smallest I/O block, a larger fan-in would make the reads too small to stay sequential.
+#define MIN_BLOCK_BYTES (256 * 1024)
+
+// Largest run, radix_sort() takes an int size.
+#define MAX_RUN_ITEMS (1 << 30)
+
+// A block of items read from or written to a file by the I/O thread.
+typedef struct block
+{
+    FILE* fp;
+    item_t* data;
+    size_t capacity;
+    size_t size; // items read, or items to write
+    bool write;
+    bool busy; // queued or in progress
+    struct block* next;
+} block_t;
+
+typedef struct
+{
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    block_t* head; // FIFO of pending blocks
+    block_t* tail;
+    bool stop;
+    bool error;
+} io_thread_t;
+
+// A run being merged: the merger consumes data[active] while the I/O thread fills the other block.
+typedef struct
+{
+    block_t block[2];
+    int active;
+    size_t pos;
+} source_t;
+
+// The list of run files waiting to be merged.
+typedef struct
+{
+    char** paths;
+    int count;
+    int capacity;
+} run_list_t;
+
+static void* io_work(void* arg)
+{
+    io_thread_t* io = (io_thread_t*)arg;
+    pthread_mutex_lock(&io->lock);
+    while (true)
+    {
+        while (io->head == NULL && !io->stop)
+        {
+            pthread_cond_wait(&io->cond, &io->lock);
+        }
+        if (io->head == NULL)
+        {
+            break;
+        }
+        block_t* b = io->head;
+        io->head = b->next;
+        if (io->head == NULL)
+        {
+            io->tail = NULL;
+        }
+        pthread_mutex_unlock(&io->lock);
+
+        bool ok;
+        if (b->write)
+        {
+            ok = fwrite(b->data, sizeof(item_t), b->size, b->fp) == b->size;
+        }
+        else
+        {
+            b->size = fread(b->data, sizeof(item_t), b->capacity, b->fp);
+            ok = !ferror(b->fp);
+        }
+
+        pthread_mutex_lock(&io->lock);
+        io->error = io->error || !ok;
+        b->busy = false;
+        pthread_cond_broadcast(&io->cond);
+    }
+    pthread_mutex_unlock(&io->lock);
+    return NULL;
+}
+
+static void io_start(io_thread_t* io)
+{
+    io->head = io->tail = NULL;
+    io->stop = false;
+    io->error = false;
+    pthread_mutex_init(&io->lock, NULL);
+    pthread_cond_init(&io->cond, NULL);
+    pthread_create(&io->thread, NULL, io_work, io);
+}
+
+// Finish the queued blocks and join the thread, return false if any of them failed.
+static bool io_stop(io_thread_t* io)
+{
+    pthread_mutex_lock(&io->lock);
+    io->stop = true;
+    pthread_cond_broadcast(&io->cond);
+    pthread_mutex_unlock(&io->lock);
+    pthread_join(io->thread, NULL);
+    pthread_mutex_destroy(&io->lock);
+    pthread_cond_destroy(&io->cond);
+    return !io->error;
+}
+
+static void io_submit(io_thread_t* io, block_t* b, bool write)
+{
+    pthread_mutex_lock(&io->lock);
+    b->write = write;
+    b->busy = true;
+    b->next = NULL;
+    if (io->tail)
+    {
+        io->tail->next = b;
+    }
+    else
+    {
+        io->head = b;
+    }
+    io->tail = b;
+    pthread_cond_signal(&io->cond);
+    pthread_mutex_unlock(&io->lock);
+}
+
+static void io_wait(io_thread_t* io, block_t* b)
+{
+    pthread_mutex_lock(&io->lock);
+    while (b->busy)
+    {
+        pthread_cond_wait(&io->cond, &io->lock);
+    }
+    pthread_mutex_unlock(&io->lock);
+}
+
+// Create an empty temp file under temp_dir and append its path to the list.
+static FILE* create_run(run_list_t* runs, const char* temp_dir)
+{
+    size_t len = strlen(temp_dir) + sizeof("/external_sort_XXXXXX");
+    char* path = (char*)sort_malloc(len);
+    snprintf(path, len, "%s/external_sort_XXXXXX", temp_dir);
+
+    int fd = mkstemp(path);
+    FILE* fp = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (fp == NULL)
+    {
+        fprintf(stderr, "ERROR: Can't create a temp file in %s: %s.\n", temp_dir, strerror(errno));
+        if (fd >= 0)
+        {
+            close(fd);
+            unlink(path);
+        }
+        free(path);
+        return NULL;
+    }
+
+    if (runs->count == runs->capacity)
+    {
+        runs->capacity = runs->capacity ? runs->capacity * 2 : 16;
+        runs->paths = (char**)realloc(runs->paths, runs->capacity * sizeof(char*));
+        check_pointer(runs->paths);
+    }
+    runs->paths[runs->count++] = path;
+    return fp;
+}
+
+static void remove_runs(run_list_t* runs, int from, int to)
+{
+    for (int i = from; i < to; i++)
+    {
+        unlink(runs->paths[i]);
+        free(runs->paths[i]);
+    }
+}
+
+// Merge runs->paths[from, to) into out with blocks carved out of `memory` bytes of space.
+static bool merge_runs(run_list_t* runs, int from, int to, FILE* out, item_t* space, size_t memory)
+{
+    int k = to - from;
+    // 每个输入两个块，输出两个块
+    size_t block_items = memory / sizeof(item_t) / (2 * (size_t)k + 2);
+
+    io_thread_t io;
+    source_t* sources = (source_t*)sort_malloc(k * sizeof(source_t));
+    block_t output[2];
+    loser_tree_t lt;
+    loser_tree_init(&lt, k);
+
+    bool ok = true;
+    int opened = 0;
+    for (; opened < k; opened++)
+    {
+        FILE* fp = fopen(runs->paths[from + opened], "rb");
+        if (fp == NULL)
+        {
+            fprintf(stderr, "ERROR: Can't open %s: %s.\n", runs->paths[from + opened], strerror(errno));
+            ok = false;
+            break;
+        }
+        setvbuf(fp, NULL, _IONBF, 0); // 块已足够大，绕过 stdio 缓冲
+        source_t* src = &sources[opened];
+        for (int j = 0; j < 2; j++)
+        {
+            src->block[j].fp = fp;
+            src->block[j].data = space + (2 * opened + j) * block_items;
+            src->block[j].capacity = block_items;
+            src->block[j].busy = false;
+        }
+        src->active = 0;
+        src->pos = 0;
+    }
+    if (!ok)
+    {
+        for (int i = 0; i < opened; i++)
+        {
+            fclose(sources[i].block[0].fp);
+        }
+        free(sources);
+        loser_tree_free(&lt);
+        return false;
+    }
+
+    io_start(&io);
+    for (int i = 0; i < k; i++)
+    {
+        io_submit(&io, &sources[i].block[0], false);
+        io_submit(&io, &sources[i].block[1], false);
+    }
+    for (int i = 0; i < k; i++)
+    {
+        io_wait(&io, &sources[i].block[0]);
+        lt.done[i] = sources[i].block[0].size == 0;
+        lt.key[i] = lt.done[i] ? 0 : sources[i].block[0].data[0];
+    }
+    loser_tree_build(&lt);
+
+    for (int j = 0; j < 2; j++)
+    {
+        output[j].fp = out;
+        output[j].data = space + (2 * k + j) * block_items;
+        output[j].capacity = block_items;
+        output[j].busy = false;
+    }
+    block_t* cur = &output[0];
+    cur->size = 0;
+
+    for (int s = loser_tree_top(&lt); !lt.done[s]; s = loser_tree_top(&lt))
+    {
+        cur->data[cur->size++] = lt.key[s];
+        if (cur->size == cur->capacity)
+        {
+            // 写出满块，切换到另一块并等待它上次的写入完成
+            io_submit(&io, cur, true);
+            cur = cur == &output[0] ? &output[1] : &output[0];
+            io_wait(&io, cur);
+            cur->size = 0;
+        }
+
+        source_t* src = &sources[s];
+        block_t* b = &src->block[src->active];
+        if (++src->pos == b->size)
+        {
+            // 当前块读完：换到预读的块，并让 I/O 线程接着读下一块
+            block_t* next = &src->block[src->active ^ 1];
+            io_wait(&io, next);
+            if (next->size == 0)
+            {
+                lt.done[s] = true;
+            }
+            else
+            {
+                src->active ^= 1;
+                src->pos = 0;
+                io_submit(&io, b, false);
+            }
+        }
+        if (!lt.done[s])
+        {
+            lt.key[s] = src->block[src->active].data[src->pos];
+        }
+        loser_tree_replay(&lt, s);
+    }
+    if (cur->size > 0)
+    {
+        io_submit(&io, cur, true);
+    }
+    ok = io_stop(&io);
+
+    for (int i = 0; i < k; i++)
+    {
+        fclose(sources[i].block[0].fp);
+    }
+    free(sources);
+    loser_tree_free(&lt);
+    if (!ok)
+    {
+        fprintf(stderr, "ERROR: I/O error while merging runs.\n");
+    }
+    return ok;
+}
+
+// Read up to `chunk` items. A short read is the end of the input, which must hold whole items:
+// a trailing partial item is an error rather than silently dropped. Return -1 on errors.
+static long read_chunk(FILE* in, item_t* space, size_t chunk)
+{
+    size_t n = fread(space, sizeof(item_t), chunk, in);
+    if (ferror(in))
+    {
+        fprintf(stderr, "ERROR: Can't read the input: %s.\n", strerror(errno));
+        return -1;
+    }
+    if (n < chunk && ftell(in) % (long)sizeof(item_t) != 0)
+    {
+        fprintf(stderr, "ERROR: The input size is not a multiple of %zu bytes.\n", sizeof(item_t));
+        return -1;
+    }
+    return (long)n;
+}
+
+// Read the input in chunks of `chunk` items, sort each one and write it to a run file. `space` has
+// room for 2 * chunk items, the second half is the scratch buffer of radix_sort_ws().
+// A single chunk goes straight to the output. Return the number of runs, or -1 on errors.
+static int create_runs(FILE* in, const char* output, run_list_t* runs, item_t* space, size_t chunk,
+                       const char* temp_dir)
+{
+    long n = read_chunk(in, space, chunk);
+    if (n < 0)
+    {
+        return -1;
+    }
+    int next = (size_t)n == chunk ? getc(in) : EOF;
+    bool single = next == EOF;
+    if (ferror(in))
+    {
+        fprintf(stderr, "ERROR: Can't read the input: %s.\n", strerror(errno));
+        return -1;
+    }
+    // 多读的一个字节放回去
+    ungetc(next, in);
+
+    // 工作区就是 space 的后一半，足够大，radix_sort_ws() 不会再分配
+    sort_workspace_t ws = {space + chunk, chunk * sizeof(item_t)};
+    while (n > 0 || single)
+    {
+        radix_sort_ws(space, (int)n, &ws);
+
+        FILE* fp = single ? fopen(output, "wb") : create_run(runs, temp_dir);
+        if (fp == NULL)
+        {
+            if (single)
+            {
+                fprintf(stderr, "ERROR: Can't open %s: %s.\n", output, strerror(errno));
+            }
+            return -1;
+        }
+        bool ok = fwrite(space, sizeof(item_t), n, fp) == (size_t)n;
+        ok = fclose(fp) == 0 && ok;
+        if (!ok)
+        {
+            fprintf(stderr, "ERROR: Can't write a sorted run: %s.\n", strerror(errno));
+            return -1;
+        }
+        if (single)
+        {
+            return 0;
+        }
+
+        n = read_chunk(in, space, chunk);
+        if (n < 0)
+        {
+            return -1;
+        }
+    }
+    return runs->count;
+}
+
+bool external_sort(const char* input, const char* output, size_t memory, const char* temp_dir)
+{
+    FILE* in = fopen(input, "rb");
+    if (in == NULL)
+    {
+        fprintf(stderr, "ERROR: Can't open %s: %s.\n", input, strerror(errno));
+        return false;
+    }
+
+    // 一半内存放数据，另一半给 radix_sort_ws 作辅助空间
+    size_t chunk = memory / sizeof(item_t) / 2;
+    chunk = chunk < SIMD_SORT_MAX ? SIMD_SORT_MAX : chunk > MAX_RUN_ITEMS ? MAX_RUN_ITEMS : chunk;
+    memory = 2 * chunk * sizeof(item_t);
+    item_t* space = (item_t*)sort_malloc(memory);
+
+    run_list_t runs = {NULL, 0, 0};
+    bool ok = create_runs(in, output, &runs, space, chunk, temp_dir) >= 0;
+    fclose(in);
+
+    // 每轮把最前面的至多 fan_in 个归并段合并为一个新段追加到末尾，最后一轮直接写到输出文件
+    int fan_in = (int)(memory / MIN_BLOCK_BYTES) / 2 - 1;
+    fan_in = fan_in < 2 ? 2 : fan_in > MAX_FAN_IN ? MAX_FAN_IN : fan_in;
+    int first = 0;
+    while (ok && runs.count - first > 0)
+    {
+        int last = runs.count - first <= fan_in ? runs.count : first + fan_in;
+        bool final = last == runs.count;
+        FILE* out = final ? fopen(output, "wb") : create_run(&runs, temp_dir);
+        if (out == NULL)
+        {
+            if (final)
+            {
+                fprintf(stderr, "ERROR: Can't open %s: %s.\n", output, strerror(errno));
+            }
+            ok = false;
+            break;
+        }
+        setvbuf(out, NULL, _IONBF, 0);
+
+        ok = merge_runs(&runs, first, last, out, space, memory);
+        ok = fclose(out) == 0 && ok;
+        remove_runs(&runs, first, last);
+        first = last;
+        if (final)
+        {
+            break;
+        }
+    }
+
+    remove_runs(&runs, first, runs.count);
+    free(runs.paths);
+    free(space);
+    return ok;
+}
@@ -0,0 +1,159 @@
+#include "sort.h"
+
+// Stable merge sort without an n-sized buffer. A merge first trims the items already in place at
+// both ends, then merges through the buffer if one side fits in it. Otherwise it splits both runs
+// at a key found by binary search, rotates the middle blocks past each other and merges the two
+// halves on their own, until the pieces fit. With a buffer of B items, runs longer than B cost
+// O(log(n / B)) extra passes of rotations, so a buffer of sqrt(n) items already gets close to the
+// buffered merge_sort, and the default one on the stack keeps the sort O(1) in memory.
+
+// Items of the stack buffer of inplace_merge_sort().
+#define INPLACE_MERGE_BUFFER 512
+
+// Runs of this length are built by insertion sort.
+#define INPLACE_MERGE_RUN 16
+
+static inline void reverse(item_t arr[], int n)
+{
+    for (int i = 0, j = n - 1; i < j; i++, j--)
+    {
+        swap(&arr[i], &arr[j]);
+    }
+}
+
+// Turn arr = A B with |A| = a, |B| = b into B A.
+static void rotate(item_t arr[], int a, int b, item_t buffer[], int size)
+{
+    if (a == 0 || b == 0)
+    {
+        return;
+    }
+    if (a <= size)
+    {
+        memcpy(buffer, arr, a * sizeof(item_t));
+        memmove(arr, arr + a, b * sizeof(item_t));
+        memcpy(arr + b, buffer, a * sizeof(item_t));
+    }
+    else if (b <= size)
+    {
+        memcpy(buffer, arr + a, b * sizeof(item_t));
+        memmove(arr + b, arr, a * sizeof(item_t));
+        memcpy(arr, buffer, b * sizeof(item_t));
+    }
+    else
+    {
+        reverse(arr, a);
+        reverse(arr + a, b);
+        reverse(arr, a + b);
+    }
+}
+
+// Merge sorted arr[0, a) and arr[a, a + b), the left run fits in the buffer.
+static inline void merge_forward(item_t arr[], int a, int b, item_t buffer[])
+{
+    memcpy(buffer, arr, a * sizeof(item_t));
+    int i = 0, j = a, k = 0;
+    while (i < a && j < a + b)
+    {
+        arr[k++] = arr[j] < buffer[i] ? arr[j++] : buffer[i++]; // 相等时先取左边，保证稳定
+    }
+    memcpy(arr + k, buffer + i, (a - i) * sizeof(item_t));
+}
+
+// Merge sorted arr[0, a) and arr[a, a + b) from the back, the right run fits in the buffer.
+static inline void merge_backward(item_t arr[], int a, int b, item_t buffer[])
+{
+    memcpy(buffer, arr + a, b * sizeof(item_t));
+    int i = a - 1, j = b - 1, k = a + b - 1;
+    while (i >= 0 && j >= 0)
+    {
+        arr[k--] = buffer[j] < arr[i] ? arr[i--] : buffer[j--]; // 相等时先放右边，保证稳定
+    }
+    memcpy(arr, buffer, (j + 1) * sizeof(item_t));
+}
+
+static void merge(item_t arr[], int a, int b, item_t buffer[], int size)
+{
+    while (a > 0 && b > 0)
+    {
+        // 左端不大于右段首元素、右端不小于左段末元素的部分已经就位
+        int skip = search_bound(arr, a, arr[a], true);
+        arr += skip;
+        a -= skip;
+        if (a == 0)
+        {
+            return;
+        }
+        b = search_bound(arr + a, b, arr[a - 1], false);
+        if (b == 0)
+        {
+            return;
+        }
+
+        if (a <= size && a <= b)
+        {
+            merge_forward(arr, a, b, buffer);
+            return;
+        }
+        if (b <= size)
+        {
+            merge_backward(arr, a, b, buffer);
+            return;
+        }
+
+        // 在较长的一段中取中点，在另一段中二分出切点，旋转后左右两半各自归并
+        int cut_a, cut_b;
+        if (a >= b)
+        {
+            cut_a = a / 2;
+            cut_b = search_bound(arr + a, b, arr[cut_a], false);
+        }
+        else
+        {
+            cut_b = b / 2;
+            cut_a = search_bound(arr, a, arr[a + cut_b], true);
+        }
+        rotate(arr + cut_a, a - cut_a, cut_b, buffer, size);
+
+        // 递归处理较短的一半，循环处理较长的一半
+        int left = cut_a + cut_b;
+        if (left < a + b - left)
+        {
+            merge(arr, cut_a, cut_b, buffer, size);
+            arr += left;
+            a -= cut_a;
+            b -= cut_b;
+        }
+        else
+        {
+            merge(arr + left, a - cut_a, b - cut_b, buffer, size);
+            a = cut_a;
+            b = cut_b;
+        }
+    }
+}
+
+void inplace_merge_sort_buffer(item_t arr[], int n, item_t buffer[], int size)
+{
+    for (int start = 0; start < n; start += INPLACE_MERGE_RUN)
+    {
+        int len = n - start < INPLACE_MERGE_RUN ? n - start : INPLACE_MERGE_RUN;
+        insertion_sort(arr + start, len);
+    }
+
+    // 自底向上两两归并
+    for (long width = INPLACE_MERGE_RUN; width < n; width *= 2)
+    {
+        for (long start = 0; start + width < n; start += 2 * width)
+        {
+            long b = n - start - width < width ? n - start - width : width;
+            merge(arr + start, (int)width, (int)b, buffer, size);
+        }
+    }
+}
+
+void inplace_merge_sort(item_t arr[], int n)
+{
+    item_t buffer[INPLACE_MERGE_BUFFER];
+    inplace_merge_sort_buffer(arr, n, buffer, INPLACE_MERGE_BUFFER);
+}
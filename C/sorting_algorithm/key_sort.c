@@ -0,0 +1,312 @@
+#include "sort.h"
+
+// Multi-key sort of records through normalized keys: the sort columns of every record are encoded
+// into one fixed-width byte string whose memcmp order is the order of the columns, followed by the
+// record index as the last tie-break. The keys are then sorted by an MSD byte radix sort that skips
+// the bytes shared by a whole bucket, and finished by insertion sort comparing from the current depth.
+//
+// Encodings, big-endian so that the most significant byte comes first:
+//   int32, int64  sign bit flipped
+//   double        f64_key(), sign bit flipped for positives and all bits flipped for negatives
+//   string        `prefix` bytes padded with zeros, then a flag byte set when the string is longer;
+//                 keys equal up to a set flag are re-sorted by comparing the full strings
+// A descending column stores all its bytes inverted.
+
+// Bytes kept from a string column whose prefix is 0.
+#define DEFAULT_STRING_PREFIX 16
+
+// Buckets smaller than this are finished by insertion sort.
+#define KEY_INSERTION_THRESHOLD 32
+
+// Bytes of the record index at the end of every key.
+#define ROW_BYTES 4
+
+static inline int column_width(const sort_column_t* column)
+{
+    switch (column->type)
+    {
+        case COLUMN_INT32:
+            return 4;
+        case COLUMN_INT64:
+        case COLUMN_DOUBLE:
+            return 8;
+        case COLUMN_STRING:
+        default:
+            return (column->prefix > 0 ? column->prefix : DEFAULT_STRING_PREFIX) + 1;
+    }
+}
+
+static inline void put_big_endian(uint8_t* out, uint64_t value, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; i--)
+    {
+        out[i] = (uint8_t)value;
+        value >>= 8;
+    }
+}
+
+int normalized_key_width(const sort_column_t columns[], int count)
+{
+    int width = 0;
+    for (int c = 0; c < count; c++)
+    {
+        width += column_width(&columns[c]);
+    }
+    return width;
+}
+
+void normalize_key(const sort_column_t columns[], int count, const void* record, uint8_t out[])
+{
+    const char* base = (const char*)record;
+    for (int c = 0; c < count; c++)
+    {
+        const sort_column_t* column = &columns[c];
+        const char* field = base + column->offset;
+        int width = column_width(column);
+        switch (column->type)
+        {
+            case COLUMN_INT32:
+            {
+                int32_t x;
+                memcpy(&x, field, sizeof(x));
+                put_big_endian(out, (uint32_t)x ^ 0x80000000u, 4);
+                break;
+            }
+            case COLUMN_INT64:
+            {
+                int64_t x;
+                memcpy(&x, field, sizeof(x));
+                put_big_endian(out, (uint64_t)x ^ 0x8000000000000000ull, 8);
+                break;
+            }
+            case COLUMN_DOUBLE:
+            {
+                double x;
+                memcpy(&x, field, sizeof(x));
+                put_big_endian(out, f64_key(x), 8);
+                break;
+            }
+            case COLUMN_STRING:
+            default:
+            {
+                const char* s;
+                memcpy(&s, field, sizeof(s));
+                int prefix = width - 1, i = 0;
+                for (; i < prefix && s[i]; i++)
+                {
+                    out[i] = (uint8_t)s[i];
+                }
+                memset(out + i, 0, prefix - i);
+                out[prefix] = i == prefix && s[i] != '\0'; // 被截断
+                break;
+            }
+        }
+        if (column->descending)
+        {
+            for (int i = 0; i < width; i++)
+            {
+                out[i] = ~out[i];
+            }
+        }
+        out += width;
+    }
+}
+
+struct key_sort
+{
+    const char* records;
+    size_t size;
+    const sort_column_t* columns;
+    int count;
+    int width;  // key bytes without the record index
+    int stride; // key bytes with the record index
+    uint8_t* space;
+};
+
+static inline uint32_t key_row(const struct key_sort* ks, const uint8_t* key)
+{
+    const uint8_t* p = key + ks->width;
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+// Insertion sort of n keys that are equal on their first `depth` bytes.
+static void insertion_sort_keys(struct key_sort* ks, uint8_t* keys, int n, int depth)
+{
+    int stride = ks->stride;
+    uint8_t* tmp = ks->space; // 桶内排序时 space 的开头可作临时缓冲
+    for (int i = 1; i < n; i++)
+    {
+        uint8_t* cur = keys + (size_t)i * stride;
+        if (memcmp(cur - stride + depth, cur + depth, stride - depth) <= 0)
+        {
+            continue;
+        }
+        memcpy(tmp, cur, stride);
+        uint8_t* p = cur;
+        do
+        {
+            memcpy(p, p - stride, stride);
+            p -= stride;
+        } while (p > keys && memcmp(p - stride + depth, tmp + depth, stride - depth) > 0);
+        memcpy(p, tmp, stride);
+    }
+}
+
+static void msd_sort(struct key_sort* ks, uint8_t* keys, int n, int depth)
+{
+    int stride = ks->stride;
+    while (n > KEY_INSERTION_THRESHOLD && depth < stride)
+    {
+        int count[256] = {0};
+        for (int i = 0; i < n; i++)
+        {
+            count[keys[(size_t)i * stride + depth]]++;
+        }
+        // 整个桶在这一字节上相同则直接看下一字节
+        if (count[keys[depth]] == n)
+        {
+            depth++;
+            continue;
+        }
+
+        int start[256];
+        int sum = 0;
+        for (int b = 0; b < 256; b++)
+        {
+            start[b] = sum;
+            sum += count[b];
+        }
+        int next[256];
+        memcpy(next, start, sizeof(next));
+        for (int i = 0; i < n; i++)
+        {
+            uint8_t* key = keys + (size_t)i * stride;
+            memcpy(ks->space + (size_t)next[key[depth]]++ * stride, key, stride);
+        }
+        memcpy(keys, ks->space, (size_t)n * stride);
+
+        for (int b = 0; b < 256; b++)
+        {
+            if (count[b] > 1)
+            {
+                msd_sort(ks, keys + (size_t)start[b] * stride, count[b], depth + 1);
+            }
+        }
+        return;
+    }
+    if (depth < stride)
+    {
+        insertion_sort_keys(ks, keys, n, depth);
+    }
+}
+
+// Compare two records on all the columns with full strings, then by index.
+static int compare_records(const struct key_sort* ks, uint32_t a, uint32_t b)
+{
+    const char* ra = ks->records + a * ks->size;
+    const char* rb = ks->records + b * ks->size;
+    for (int c = 0; c < ks->count; c++)
+    {
+        const sort_column_t* column = &ks->columns[c];
+        uint8_t ka[8], kb[8];
+        int r;
+        if (column->type == COLUMN_STRING)
+        {
+            const char *sa, *sb;
+            memcpy(&sa, ra + column->offset, sizeof(sa));
+            memcpy(&sb, rb + column->offset, sizeof(sb));
+            r = strcmp(sa, sb);
+            r = (r > 0) - (r < 0);
+            r = column->descending ? -r : r;
+        }
+        else
+        {
+            // 数值列复用规范化编码
+            normalize_key(column, 1, ra, ka);
+            normalize_key(column, 1, rb, kb);
+            r = memcmp(ka, kb, column_width(column));
+        }
+        if (r != 0)
+        {
+            return r;
+        }
+    }
+    return (a > b) - (a < b);
+}
+
+// Stable merge sort of n keys by compare_records(), through the row indices.
+static void merge_sort_rows(const struct key_sort* ks, uint32_t rows[], uint32_t space[], int n)
+{
+    if (n < 2)
+    {
+        return;
+    }
+    int mid = n / 2;
+    merge_sort_rows(ks, rows, space, mid);
+    merge_sort_rows(ks, rows + mid, space, n - mid);
+    memcpy(space, rows, mid * sizeof(uint32_t));
+    int i = 0, j = mid, k = 0;
+    while (i < mid && j < n)
+    {
+        rows[k++] = compare_records(ks, rows[j], space[i]) < 0 ? rows[j++] : space[i++];
+    }
+    memcpy(rows + k, space + i, (mid - i) * sizeof(uint32_t));
+}
+
+void sort_by_columns_ws(const void* records, int n, size_t size, const sort_column_t columns[], int count,
+                        uint32_t order[], sort_workspace_t* ws)
+{
+    struct key_sort ks = {(const char*)records, size, columns, count, normalized_key_width(columns, count)};
+    ks.stride = ks.width + ROW_BYTES;
+    // 键数组和 MSD 排序的辅助空间各占工作区的一半，后一半按 8 字节对齐以便当作 uint32_t 数组用
+    size_t bytes = ((size_t)n * ks.stride + ks.stride + 7) & ~(size_t)7;
+    uint8_t* keys = (uint8_t*)sort_workspace_reserve(ws, 2 * bytes);
+    ks.space = keys + bytes;
+
+    for (int i = 0; i < n; i++)
+    {
+        uint8_t* key = keys + (size_t)i * ks.stride;
+        normalize_key(columns, count, ks.records + i * size, key);
+        put_big_endian(key + ks.width, (uint32_t)i, ROW_BYTES);
+    }
+    msd_sort(&ks, keys, n, 0);
+    for (int i = 0; i < n; i++)
+    {
+        order[i] = key_row(&ks, keys + (size_t)i * ks.stride);
+    }
+
+    // 前缀与截断标志都相同的连续记录按完整字符串重新排序
+    int end = 0;
+    for (int c = 0; c < count; c++)
+    {
+        end += column_width(&columns[c]);
+        if (columns[c].type != COLUMN_STRING)
+        {
+            continue;
+        }
+        uint8_t truncated = columns[c].descending ? 0xFE : 1;
+        for (int i = 0; i < n;)
+        {
+            const uint8_t* first = keys + (size_t)i * ks.stride;
+            int j = i + 1;
+            while (j < n && memcmp(first, keys + (size_t)j * ks.stride, end) == 0)
+            {
+                j++;
+            }
+            if (j - i > 1 && first[end - 1] == truncated)
+            {
+                merge_sort_rows(&ks, order + i, (uint32_t*)ks.space, j - i);
+            }
+            i = j;
+        }
+    }
+}
+
+void sort_by_columns(const void* records, int n, size_t size, const sort_column_t columns[], int count,
+                     uint32_t order[])
+{
+    sort_workspace_t ws;
+    sort_workspace_init(&ws, 0);
+    sort_by_columns_ws(records, n, size, columns, count, order, &ws);
+    sort_workspace_free(&ws);
+}
@@ -0,0 +1,91 @@
+#ifndef LOSER_TREE_H
+#define LOSER_TREE_H
+
+#include "sort.h"
+
+// Tournament tree of losers for a k-way merge: node[0] holds the source with the smallest head,
+// node[1, k) the loser of each match, leaf s sits at k + s of the implicit complete binary tree.
+// Ties go to the lower source, which keeps the merge stable.
+typedef struct
+{
+    int k;
+    int* node;
+    item_t* key; // current head of every source
+    bool* done;  // the source is exhausted
+} loser_tree_t;
+
+// Allocate a tree of k sources, set key[] and done[] then call loser_tree_build().
+static inline void loser_tree_init(loser_tree_t* lt, int k)
+{
+    lt->k = k;
+    lt->node = (int*)sort_malloc((k > 1 ? k : 1) * sizeof(int));
+    lt->key = (item_t*)sort_malloc(k * sizeof(item_t));
+    lt->done = (bool*)sort_malloc(k * sizeof(bool));
+}
+
+static inline void loser_tree_free(loser_tree_t* lt)
+{
+    free(lt->node);
+    free(lt->key);
+    free(lt->done);
+}
+
+// Whether source a wins against source b.
+static inline bool loser_tree_beats(const loser_tree_t* lt, int a, int b)
+{
+    if (lt->done[a] || lt->done[b])
+    {
+        return !lt->done[a] || (lt->done[b] && a < b);
+    }
+    return lt->key[a] < lt->key[b] || (lt->key[a] == lt->key[b] && a < b);
+}
+
+static inline void loser_tree_build(loser_tree_t* lt)
+{
+    int k = lt->k;
+    if (k == 1)
+    {
+        lt->node[0] = 0;
+        return;
+    }
+
+    // 自底向上比赛，winner[i] 为结点 i 的胜者，node[i] 记录败者
+    int* winner = (int*)sort_malloc(2 * k * sizeof(int));
+    for (int s = 0; s < k; s++)
+    {
+        winner[k + s] = s;
+    }
+    for (int i = k - 1; i > 0; i--)
+    {
+        int a = winner[2 * i], b = winner[2 * i + 1];
+        bool a_wins = loser_tree_beats(lt, a, b);
+        winner[i] = a_wins ? a : b;
+        lt->node[i] = a_wins ? b : a;
+    }
+    lt->node[0] = winner[1];
+    free(winner);
+}
+
+// Source of the smallest head, check done[] to see whether every source is exhausted.
+static inline int loser_tree_top(const loser_tree_t* lt)
+{
+    return lt->node[0];
+}
+
+// Replay the matches from leaf s to the root after key[s] or done[s] changed, s must be the current winner.
+static inline void loser_tree_replay(loser_tree_t* lt, int s)
+{
+    int winner = s;
+    for (int i = (lt->k + s) / 2; i > 0; i /= 2)
+    {
+        if (loser_tree_beats(lt, lt->node[i], winner))
+        {
+            int tmp = lt->node[i];
+            lt->node[i] = winner;
+            winner = tmp;
+        }
+    }
+    lt->node[0] = winner;
+}
+
+#endif // LOSER_TREE_H
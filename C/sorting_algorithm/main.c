@@ -1,117 +1,1274 @@
+#include "bench.h"
+#include "btree.h"
+#include "pqueue.h"
 #include "sort.h"
+#include "thread_pool.h"
 
-#include <time.h>
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
 
+// Size of the typed sort test.
 #define TEST_SIZE 32768
 
 #define USER_SIZE 100
 
+// Quadratic sorts are skipped on larger inputs.
+#define QUADRATIC_MAX_SIZE 65536
+
+// Defaults of the benchmark, the sizes grow tenfold from min to max.
+#define DEFAULT_MIN_SIZE 1000
+#define DEFAULT_MAX_SIZE 1000000
+#define DEFAULT_TRIALS 5
+#define DEFAULT_WARMUP 1
+#define DEFAULT_SEED 20240607
+
+// Chunk size of the streaming top-k benchmark.
+#define TOPK_CHUNK 4096
+
+// Default memory budget of the external sort in MB.
+#define DEFAULT_MEMORY_MB 1024
+
 typedef void (*sort_func_t)(item_t* arr, int n);
 
-int order_cmp(const void* a, const void* b)
+struct algorithm
+{
+    const char* name;
+    sort_func_t func;
+    int max_size;
+};
+
+struct bench_config
+{
+    long min_size;
+    long max_size;
+    int trials;
+    int warmup;
+    uint64_t seed;
+    const char* csv_path;
+    const char* json_path;
+    int threads; // most threads of the scaling test
+};
+
+typedef void (*parallel_sort_func_t)(item_t* arr, int n, int threads);
+
+struct parallel_algorithm
+{
+    const char* name;
+    parallel_sort_func_t func;
+};
+
+struct parallel_algorithm parallel_algorithms[] = {
+    {"parallel quick sort", parallel_quick_sort},
+    {"parallel sample sort", parallel_sample_sort},
+    {"parallel merge sort", parallel_merge_sort},
+    {"parallel in-place radix", parallel_radix_sort_inplace},
+    {"parallel counting sort", parallel_counting_sort},
+};
+
+#define PARALLEL_ALGORITHM_COUNT ((int)(sizeof(parallel_algorithms) / sizeof(parallel_algorithms[0])))
+
+static void parallel_quick_sort_all(item_t arr[], int n)
+{
+    parallel_quick_sort(arr, n, 0);
+}
+
+static void parallel_sample_sort_all(item_t arr[], int n)
+{
+    parallel_sample_sort(arr, n, 0);
+}
+
+static void parallel_merge_sort_all(item_t arr[], int n)
 {
-    return (*(item_t*)a) - (*(item_t*)b);
+    parallel_merge_sort(arr, n, 0);
 }
 
-int reverse_cmp(const void* a, const void* b)
+static void parallel_radix_sort_inplace_all(item_t arr[], int n)
 {
-    return (*(item_t*)b) - (*(item_t*)a);
+    parallel_radix_sort_inplace(arr, n, 0);
 }
 
-struct result
+static void parallel_counting_sort_all(item_t arr[], int n)
 {
-    double random_time;
-    double order_time;
-    double reverse_time;
-    item_t* data;
+    parallel_counting_sort(arr, n, 0);
+}
+
+// Quick sort goes first, it is the reference of the speedup column.
+struct algorithm algorithms[] = {
+    {"quick sort", quick_sort, INT_MAX},
+    {"auto sort", auto_sort, INT_MAX},
+    {"parallel quick sort", parallel_quick_sort_all, INT_MAX},
+    {"parallel sample sort", parallel_sample_sort_all, INT_MAX},
+    {"parallel merge sort", parallel_merge_sort_all, INT_MAX},
+    {"parallel in-place radix", parallel_radix_sort_inplace_all, INT_MAX},
+    {"parallel counting sort", parallel_counting_sort_all, INT_MAX},
+    {"heap sort", heap_sort, INT_MAX},
+    {"4-ary heap sort", heap4_sort, INT_MAX},
+    {"8-ary heap sort", heap8_sort, INT_MAX},
+    {"merge sort", merge_sort, INT_MAX},
+    {"in-place merge sort", inplace_merge_sort, INT_MAX},
+    {"tim sort", tim_sort, INT_MAX},
+    {"radix sort", radix_sort, INT_MAX},
+    {"in-place radix sort", radix_sort_inplace, INT_MAX},
+    {"counting sort", counting_sort, INT_MAX},
+    {"simd sort", simd_sort, INT_MAX},
+    {"shell sort", shell_sort, INT_MAX},
+    {"insertion sort", insertion_sort, QUADRATIC_MAX_SIZE},
+    {"selection sort", selection_sort, QUADRATIC_MAX_SIZE},
+    {"bubble sort", bubble_sort, QUADRATIC_MAX_SIZE},
 };
 
-static item_t random[TEST_SIZE], order[TEST_SIZE], reverse[TEST_SIZE];
+#define ALGORITHM_COUNT ((int)(sizeof(algorithms) / sizeof(algorithms[0])))
 
-void prepare_data()
+// Sort copies of `input` after `warmup` untimed runs, verify the order and the checksum of every timed run.
+struct bench_record run_benchmark(const struct algorithm* algorithm, const item_t input[], item_t work[], int n,
+                                  checksum_t expect, const struct bench_config* config)
 {
-    srand(time(NULL));
-    for (int i = 0; i < TEST_SIZE; ++i)
+    struct bench_record record = {algorithm->name, NULL, n, config->trials, {0, 0, 0}, 0, 0, true};
+    double* samples = (double*)malloc(config->trials * sizeof(double));
+    check_pointer(samples);
+
+    for (int i = 0; i < config->warmup; i++)
     {
-        random[i] = order[i] = reverse[i] = rand();
+        memcpy(work, input, n * sizeof(item_t));
+        algorithm->func(work, n);
     }
-    qsort(order, TEST_SIZE, sizeof(item_t), order_cmp);
-    qsort(reverse, TEST_SIZE, sizeof(item_t), reverse_cmp);
+
+    peak_rss_reset();
+    long allocs = sort_alloc_count();
+    for (int i = 0; i < config->trials; i++)
+    {
+        memcpy(work, input, n * sizeof(item_t));
+        double start = now_ns();
+        algorithm->func(work, n);
+        samples[i] = (now_ns() - start) / n;
+        record.verified = record.verified && is_sorted(work, n) && checksum_equal(checksum(work, n), expect);
+    }
+    record.allocs = (double)(sort_alloc_count() - allocs) / config->trials;
+    record.peak_rss_kb = peak_rss_kb();
+    record.ns_per_item = compute_stats(samples, config->trials);
+
+    free(samples);
+    return record;
+}
+
+static uint64_t rand64(void)
+{
+    return ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+}
+
+static int i64_cmp(const void* a, const void* b)
+{
+    int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int f64_cmp(const void* a, const void* b)
+{
+    uint64_t x = f64_key(*(const double*)a), y = f64_key(*(const double*)b);
+    return (x > y) - (x < y);
+}
+
+static int record_cmp(const void* a, const void* b)
+{
+    uint64_t x = ((const record_t*)a)->key, y = ((const record_t*)b)->key;
+    return (x > y) - (x < y);
+}
+
+// Records start out in row order, so a stable sort must also keep the rows of equal keys ascending.
+static int record_stable_cmp(const void* a, const void* b)
+{
+    int c = record_cmp(a, b);
+    return c != 0 ? c : (int)((const record_t*)a)->row - (int)((const record_t*)b)->row;
+}
+
+static void i64_qsort(int64_t arr[], int n)
+{
+    qsort(arr, n, sizeof(int64_t), i64_cmp);
+}
+
+static void f64_qsort(double arr[], int n)
+{
+    qsort(arr, n, sizeof(double), f64_cmp);
+}
+
+static void record_qsort(record_t arr[], int n)
+{
+    qsort(arr, n, sizeof(record_t), record_cmp);
 }
 
-struct result time_test(sort_func_t method)
+// Time `sort` on a copy of `data` and check the result with `cmp`.
+#define TYPED_TEST(TYPE, sort, data, cmp)                                               \
+    do                                                                                  \
+    {                                                                                   \
+        static TYPE work[TEST_SIZE];                                                    \
+        memcpy(work, data, sizeof(work));                                               \
+        double start = now_ns();                                                        \
+        sort(work, TEST_SIZE);                                                          \
+        double time = (now_ns() - start) * 1e-9;                                        \
+        bool sorted = true;                                                             \
+        for (int i = 1; i < TEST_SIZE && sorted; i++)                                   \
+        {                                                                               \
+            sorted = cmp(&work[i - 1], &work[i]) <= 0;                                  \
+        }                                                                               \
+        printf("%s:\t%lfs\t%s\n", #sort, time, sorted ? "ok" : "WRONG ORDER");          \
+    } while (0)
+
+void type_test(void)
 {
-    static item_t random_local[TEST_SIZE], order_local[TEST_SIZE], reverse_local[TEST_SIZE];
-    // 生成数据
+    static int64_t i64_data[TEST_SIZE];
+    static double f64_data[TEST_SIZE];
+    static record_t record_data[TEST_SIZE];
     for (int i = 0; i < TEST_SIZE; ++i)
     {
-        random_local[i] = random[i];
-        order_local[i] = order[i];
-        reverse_local[i] = reverse[i];
+        i64_data[i] = (int64_t)rand64();
+        f64_data[i] = ((double)rand() - RAND_MAX / 2) / (rand() + 1);
+        record_data[i].key = rand64() % (TEST_SIZE / 8); // 制造重复键以检验稳定性
+        record_data[i].row = i;
+    }
+
+    printf("\nint64_t:\n");
+    TYPED_TEST(int64_t, i64_qsort, i64_data, i64_cmp);
+    TYPED_TEST(int64_t, i64_sort, i64_data, i64_cmp);
+    TYPED_TEST(int64_t, i64_stable_sort, i64_data, i64_cmp);
+    TYPED_TEST(int64_t, i64_radix_sort, i64_data, i64_cmp);
+    TYPED_TEST(int64_t, i64_radix_sort_inplace, i64_data, i64_cmp);
+
+    printf("\ndouble:\n");
+    TYPED_TEST(double, f64_qsort, f64_data, f64_cmp);
+    TYPED_TEST(double, f64_sort, f64_data, f64_cmp);
+    TYPED_TEST(double, f64_stable_sort, f64_data, f64_cmp);
+    TYPED_TEST(double, f64_radix_sort, f64_data, f64_cmp);
+    TYPED_TEST(double, f64_radix_sort_inplace, f64_data, f64_cmp);
+
+    printf("\nrecord_t (stable sorts also checked for row order):\n");
+    TYPED_TEST(record_t, record_qsort, record_data, record_cmp);
+    TYPED_TEST(record_t, record_sort, record_data, record_cmp);
+    TYPED_TEST(record_t, record_stable_sort, record_data, record_stable_cmp);
+    TYPED_TEST(record_t, record_radix_sort, record_data, record_stable_cmp);
+    TYPED_TEST(record_t, record_radix_sort_inplace, record_data, record_cmp);
+}
+
+// Median time in ns of sorting copies of `input` with `threads` threads, clear *verified on a wrong result.
+static double time_parallel(parallel_sort_func_t func, const item_t input[], item_t work[], int n, int threads,
+                            const struct bench_config* config, bool* verified)
+{
+    double* samples = (double*)malloc(config->trials * sizeof(double));
+    check_pointer(samples);
+    checksum_t expect = checksum(input, n);
+
+    for (int i = -config->warmup; i < config->trials; i++)
+    {
+        memcpy(work, input, n * sizeof(item_t));
+        double start = now_ns();
+        func(work, n, threads);
+        if (i >= 0)
+        {
+            samples[i] = now_ns() - start;
+        }
+        *verified = *verified && is_sorted(work, n) && checksum_equal(checksum(work, n), expect);
+    }
+
+    double median = compute_stats(samples, config->trials).median;
+    free(samples);
+    return median;
+}
+
+// Strong scaling sorts max_size items with 1, 2, 4, ... threads, weak scaling gives every thread
+// max_size / threads items. Efficiency is the speedup over one thread divided by the threads
+// (strong), or the time of one thread over the time of all of them (weak).
+void scaling_test(const struct bench_config* config)
+{
+    int counts[32];
+    int steps = 0;
+    for (int t = 1; t < config->threads; t *= 2)
+    {
+        counts[steps++] = t;
+    }
+    counts[steps++] = config->threads;
+
+    long n = config->max_size;
+    long per_thread = n / config->threads > 0 ? n / config->threads : 1;
+    item_t* input = (item_t*)malloc(n * sizeof(item_t));
+    item_t* work = (item_t*)malloc(n * sizeof(item_t));
+    check_pointer(input);
+    check_pointer(work);
+
+    for (int weak = 0; weak <= 1; weak++)
+    {
+        printf("\n%s scaling, %ld items%s, random input\n", weak ? "weak" : "strong", weak ? per_thread : n,
+               weak ? " per thread" : "");
+        printf("%-22s%8s%12s%10s%12s%8s\n", "algorithm", "threads", "time(ms)", "speedup", "efficiency", "check");
+        for (int a = 0; a < PARALLEL_ALGORITHM_COUNT; a++)
+        {
+            double base = 0;
+            for (int i = 0; i < steps; i++)
+            {
+                int threads = counts[i];
+                int size = (int)(weak ? per_thread * threads : n);
+                generate(input, size, DIST_RANDOM, config->seed);
+
+                bool verified = true;
+                double time = time_parallel(parallel_algorithms[a].func, input, work, size, threads, config, &verified);
+                base = i == 0 ? time : base;
+                double speedup = weak ? base * threads / time : base / time;
+                printf("%-22s%8d%12.3f%9.2fx%11.0f%%%8s\n", parallel_algorithms[a].name, threads, time * 1e-6, speedup,
+                       100.0 * speedup / threads, verified ? "ok" : "WRONG");
+            }
+        }
+    }
+
+    free(input);
+    free(work);
+}
+
+enum topk_method
+{
+    TOPK_QUICK_SORT,
+    TOPK_PARTIAL_SORT,
+    TOPK_SELECT_NTH,
+    TOPK_STREAM,
+    TOPK_METHOD_COUNT
+};
+
+const char* topk_method_names[TOPK_METHOD_COUNT] = {
+    "quick sort + truncate", "partial sort", "select nth", "streaming top-k"};
+
+// Put the k smallest items of input into out with the given method, return the time in ns.
+// Select nth leaves them unordered, the streaming top-k reads the input in chunks.
+static double smallest_k(enum topk_method method, const item_t input[], item_t work[], int n, int k, item_t out[])
+{
+    double start = now_ns();
+    if (method == TOPK_STREAM)
+    {
+        topk_t topk;
+        topk_init(&topk, k);
+        for (int i = 0; i < n; i += TOPK_CHUNK)
+        {
+            topk_push(&topk, input + i, n - i < TOPK_CHUNK ? n - i : TOPK_CHUNK);
+        }
+        topk_result(&topk, out);
+        topk_free(&topk);
+        return now_ns() - start;
+    }
+
+    memcpy(work, input, n * sizeof(item_t));
+    start = now_ns();
+    switch (method)
+    {
+        case TOPK_QUICK_SORT:
+            quick_sort(work, n);
+            break;
+        case TOPK_PARTIAL_SORT:
+            partial_sort(work, n, k);
+            break;
+        default:
+            select_nth(work, n, k - 1);
+            break;
+    }
+    double time = now_ns() - start;
+    memcpy(out, work, k * sizeof(item_t));
+    return time;
+}
+
+// The smallest k items of max_size random items, against a full quick sort truncated to k.
+void topk_test(const struct bench_config* config)
+{
+    int n = (int)config->max_size;
+    int ks[] = {100, 10000};
+    item_t* input = (item_t*)malloc(n * sizeof(item_t));
+    item_t* work = (item_t*)malloc(n * sizeof(item_t));
+    item_t* expect = (item_t*)malloc(n * sizeof(item_t));
+    item_t* out = (item_t*)malloc(n * sizeof(item_t));
+    double* samples = (double*)malloc(config->trials * sizeof(double));
+    check_pointer(input);
+    check_pointer(work);
+    check_pointer(expect);
+    check_pointer(out);
+    check_pointer(samples);
+
+    generate(input, n, DIST_RANDOM, config->seed);
+    memcpy(expect, input, n * sizeof(item_t));
+    quick_sort(expect, n);
+
+    for (int i = 0; i < (int)(sizeof(ks) / sizeof(ks[0])); i++)
+    {
+        int k = ks[i] < n ? ks[i] : n;
+        printf("\nsmallest %d of %d random items\n", k, n);
+        printf("%-24s%12s%10s%8s\n", "method", "time(ms)", "x quick", "check");
+
+        double reference = 0;
+        for (int method = 0; method < TOPK_METHOD_COUNT; method++)
+        {
+            bool verified = true;
+            for (int t = -config->warmup; t < config->trials; t++)
+            {
+                double time = smallest_k(method, input, work, n, k, out);
+                if (t >= 0)
+                {
+                    samples[t] = time;
+                }
+                if (method == TOPK_SELECT_NTH)
+                {
+                    quick_sort(out, k);
+                }
+                verified = verified && memcmp(out, expect, k * sizeof(item_t)) == 0;
+            }
+            double median = compute_stats(samples, config->trials).median;
+            reference = method == TOPK_QUICK_SORT ? median : reference;
+            printf("%-24s%12.3f%9.2fx%8s\n", topk_method_names[method], median * 1e-6, reference / median,
+                   verified ? "ok" : "WRONG");
+        }
+    }
+
+    free(input);
+    free(work);
+    free(expect);
+    free(out);
+    free(samples);
+}
+
+struct person
+{
+    int32_t age;
+    double score;
+    const char* name;
+};
+
+// Column lists of the multi-key test and the chained comparators they replace.
+const sort_column_t by_age_name[] = {
+    {COLUMN_INT32, offsetof(struct person, age), false, 0},
+    {COLUMN_STRING, offsetof(struct person, name), false, 0},
+};
+
+const sort_column_t by_score_desc_name[] = {
+    {COLUMN_DOUBLE, offsetof(struct person, score), true, 0},
+    {COLUMN_STRING, offsetof(struct person, name), false, 0},
+};
+
+static int person_age_name_cmp(const void* a, const void* b)
+{
+    const struct person* p1 = a;
+    const struct person* p2 = b;
+    if (p1->age != p2->age)
+    {
+        return (p1->age > p2->age) - (p1->age < p2->age);
+    }
+    return strcmp(p1->name, p2->name);
+}
+
+static int person_score_desc_name_cmp(const void* a, const void* b)
+{
+    const struct person* p1 = a;
+    const struct person* p2 = b;
+    if (p1->score != p2->score)
+    {
+        return (p1->score < p2->score) - (p1->score > p2->score);
+    }
+    return strcmp(p1->name, p2->name);
+}
+
+// Sort records by two columns with chained comparators in qsort, and with normalized keys.
+void multikey_test(const struct bench_config* config)
+{
+    int n = (int)config->max_size;
+    struct person* people = (struct person*)malloc(n * sizeof(struct person));
+    struct person* work = (struct person*)malloc(n * sizeof(struct person));
+    uint32_t* order = (uint32_t*)malloc(n * sizeof(uint32_t));
+    char* names = (char*)malloc(n * 32);
+    check_pointer(people);
+    check_pointer(work);
+    check_pointer(order);
+    check_pointer(names);
+
+    // 一部分名字共享较长的前缀，覆盖前缀截断后的比较
+    item_t* random_values = (item_t*)malloc(3 * n * sizeof(item_t));
+    check_pointer(random_values);
+    generate(random_values, 3 * n, DIST_RANDOM, config->seed);
+    for (int i = 0; i < n; i++)
+    {
+        unsigned r = (unsigned)random_values[3 * i];
+        char* name = names + i * 32;
+        snprintf(name, 32, "%s%08x", r % 4 == 0 ? "anonymous_user_" : "", (unsigned)random_values[3 * i + 1]);
+        people[i].name = name;
+        people[i].age = r % 100;
+        people[i].score = (random_values[3 * i + 2] % 1000) / 10.0;
     }
+    free(random_values);
+
+    const sort_column_t* columns[] = {by_age_name, by_score_desc_name};
+    int (*cmps[])(const void*, const void*) = {person_age_name_cmp, person_score_desc_name_cmp};
+    const char* names_of_sets[] = {"age, name", "score desc, name"};
 
-    clock_t start, end;
-    struct result result;
+    printf("\nmulti-key sort of %d records\n", n);
+    printf("%-20s%16s%16s%10s%8s\n", "columns", "qsort(ms)", "keys(ms)", "speedup", "check");
+    for (int set = 0; set < 2; set++)
+    {
+        memcpy(work, people, n * sizeof(struct person));
+        double start = now_ns();
+        qsort(work, n, sizeof(struct person), cmps[set]);
+        double qsort_time = now_ns() - start;
+
+        // 排序规范化键并按结果收集记录，与 qsort 的输出对等
+        start = now_ns();
+        sort_by_columns(people, n, sizeof(struct person), columns[set], 2, order);
+        for (int i = 0; i < n; i++)
+        {
+            work[i] = people[order[i]];
+        }
+        double key_time = now_ns() - start;
+
+        bool verified = true;
+        for (int i = 1; i < n && verified; i++)
+        {
+            verified = cmps[set](&work[i - 1], &work[i]) <= 0;
+        }
+        printf("%-20s%16.3f%16.3f%9.2fx%8s\n", names_of_sets[set], qsort_time * 1e-6, key_time * 1e-6,
+               qsort_time / key_time, verified ? "ok" : "WRONG");
+    }
 
-    // 随机数据排序
-    start = clock();
-    method(random_local, TEST_SIZE);
-    end = clock();
-    result.random_time = (double)(end - start) / CLOCKS_PER_SEC;
+    free(people);
+    free(work);
+    free(order);
+    free(names);
+}
 
-    // 顺序数据排序
-    start = clock();
-    method(order_local, TEST_SIZE);
-    end = clock();
-    result.order_time = (double)(end - start) / CLOCKS_PER_SEC;
+// Penalty of the stable merge sort with little or no buffer against the buffered merge_sort.
+void inplace_merge_test(const struct bench_config* config)
+{
+    int n = (int)config->max_size;
+    int sqrt_n = 1;
+    while ((long)sqrt_n * sqrt_n < n)
+    {
+        sqrt_n++;
+    }
+    item_t* input = (item_t*)malloc(n * sizeof(item_t));
+    item_t* work = (item_t*)malloc(n * sizeof(item_t));
+    item_t* buffer = (item_t*)malloc((n / 2 + 1) * sizeof(item_t));
+    check_pointer(input);
+    check_pointer(work);
+    check_pointer(buffer);
 
-    // 逆序数据排序
-    start = clock();
-    method(reverse_local, TEST_SIZE);
-    end = clock();
-    result.reverse_time = (double)(end - start) / CLOCKS_PER_SEC;
+    const char* names[] = {"merge sort", "stack buffer", "sqrt(n) buffer", "n/2 buffer"};
+    int sizes[] = {0, 0, sqrt_n, n / 2};
+    printf("\nstable merge sort of %d items by buffer size\n", n);
+    printf("%-14s%-16s%12s%14s%8s\n", "input", "buffer", "time(ms)", "x merge sort", "check");
+    for (int dist = 0; dist < DIST_COUNT; dist++)
+    {
+        if (dist != DIST_RANDOM && dist != DIST_FEW_UNIQUE && dist != DIST_SAWTOOTH)
+        {
+            continue;
+        }
+        generate(input, n, dist, config->seed + dist);
+        checksum_t expect = checksum(input, n);
 
-    result.data = random_local;
+        double reference = 0;
+        for (int v = 0; v < 4; v++)
+        {
+            memcpy(work, input, n * sizeof(item_t));
+            double start = now_ns();
+            if (v == 0)
+            {
+                merge_sort(work, n);
+            }
+            else if (v == 1)
+            {
+                inplace_merge_sort(work, n);
+            }
+            else
+            {
+                inplace_merge_sort_buffer(work, n, buffer, sizes[v]);
+            }
+            double time = now_ns() - start;
+            reference = v == 0 ? time : reference;
+            bool verified = is_sorted(work, n) && checksum_equal(checksum(work, n), expect);
+            printf("%-14s%-16s%12.3f%13.2fx%8s\n", distribution_names[dist], names[v], time * 1e-6,
+                   time / reference, verified ? "ok" : "WRONG");
+        }
+    }
 
-    return result;
+    free(input);
+    free(work);
+    free(buffer);
 }
 
-sort_func_t functions[] = {
-    heap_sort, insertion_sort, merge_sort, quick_sort, radix_sort, selection_sort, shell_sort, bubble_sort};
+struct workspace_algorithm
+{
+    const char* name;
+    sort_func_t func;
+    void (*func_ws)(item_t* arr, int n, sort_workspace_t* ws);
+};
 
-const char* func_names[] = {
-    "heap sort", "insertion sort", "merge sort", "quick sort", "radix sort", "selection sort", "shell sort", "bubble sort"};
+// Sort the input in batches of `batch` items, each by a fresh call, with or without a shared workspace.
+static double sort_batches(const struct workspace_algorithm* algorithm, item_t work[], int n, int batch,
+                           sort_workspace_t* ws)
+{
+    double start = now_ns();
+    for (int i = 0; i < n; i += batch)
+    {
+        int size = n - i < batch ? n - i : batch;
+        if (ws)
+        {
+            algorithm->func_ws(work + i, size, ws);
+        }
+        else
+        {
+            algorithm->func(work + i, size);
+        }
+    }
+    return now_ns() - start;
+}
 
-void test_mode(void)
+// Sort many small batches with the allocating sorts and with one reused workspace.
+void workspace_test(const struct bench_config* config)
 {
-    printf("TEST_SIZE: %d\n", TEST_SIZE);
-    printf("\t\trandom_time\torder_time\treverse_time\tdata\n");
-    struct result result;
+    const struct workspace_algorithm workspace_algorithms[] = {
+        {"merge sort", merge_sort, merge_sort_ws},
+        {"tim sort", tim_sort, tim_sort_ws},
+        {"radix sort", radix_sort, radix_sort_ws},
+        {"simd sort", simd_sort, simd_sort_ws},
+        {"auto sort", auto_sort, auto_sort_ws},
+    };
+    int batches[] = {256, 4096};
+    int n = (int)config->max_size;
+    item_t* input = (item_t*)malloc(n * sizeof(item_t));
+    item_t* work = (item_t*)malloc(n * sizeof(item_t));
+    check_pointer(input);
+    check_pointer(work);
+    generate(input, n, DIST_RANDOM, config->seed);
 
-    prepare_data();
-    for (int i = 0; i < sizeof(functions) / sizeof(sort_func_t); ++i)
+    printf("\n%d random items sorted in batches, with and without a workspace\n", n);
+    printf("%-14s%8s%14s%10s%14s%10s%10s%8s\n", "algorithm", "batch", "malloc(ms)", "allocs", "workspace(ms)",
+           "allocs", "speedup", "check");
+    for (int b = 0; b < (int)(sizeof(batches) / sizeof(batches[0])); b++)
     {
-        result = time_test(functions[i]);
-        printf("%s:\t%lfs\t%lfs\t%lfs\t", func_names[i], result.random_time, result.order_time, result.reverse_time);
-        for (int i = 0; i < 10; i++)
+        for (int i = 0; i < (int)(sizeof(workspace_algorithms) / sizeof(workspace_algorithms[0])); i++)
         {
-            printf("%d ", result.data[i]);
+            const struct workspace_algorithm* algorithm = &workspace_algorithms[i];
+
+            memcpy(work, input, n * sizeof(item_t));
+            long allocs = sort_alloc_count();
+            double plain_time = sort_batches(algorithm, work, n, batches[b], NULL);
+            long plain_allocs = sort_alloc_count() - allocs;
+
+            sort_workspace_t ws;
+            sort_workspace_init(&ws, 0);
+            memcpy(work, input, n * sizeof(item_t));
+            allocs = sort_alloc_count();
+            double ws_time = sort_batches(algorithm, work, n, batches[b], &ws);
+            long ws_allocs = sort_alloc_count() - allocs;
+            sort_workspace_free(&ws);
+
+            bool verified = true;
+            for (int j = 0; j < n && verified; j += batches[b])
+            {
+                verified = is_sorted(work + j, n - j < batches[b] ? n - j : batches[b]);
+            }
+            printf("%-14s%8d%14.3f%10ld%14.3f%10ld%9.2fx%8s\n", algorithm->name, batches[b], plain_time * 1e-6,
+                   plain_allocs, ws_time * 1e-6, ws_allocs, plain_time / ws_time, verified ? "ok" : "WRONG");
         }
-        printf("...\n");
     }
+
+    free(input);
+    free(work);
+}
+
+enum ordered_method
+{
+    ORDERED_QUICK_SORT,
+    ORDERED_MERGE,
+    ORDERED_BTREE_BATCH,
+    ORDERED_BTREE_INSERT,
+    ORDERED_METHOD_COUNT
+};
+
+const char* ordered_method_names[ORDERED_METHOD_COUNT] = {
+    "quick sort all", "sort + merge", "btree batch", "btree insert"};
+
+// Batches inserted after the initial load of the ordered container test, each of n / 1000 items.
+#define ORDERED_BATCHES 20
+
+// Keep n random items ordered under batches of inserts: re-sort the array after every batch, sort
+// the batch and merge it into the array, or insert it into a B+tree. Then look up n random keys.
+void btree_test(const struct bench_config* config)
+{
+    int n = (int)config->max_size;
+    int batch = n / 1000 > 0 ? n / 1000 : 1;
+    int total = n + ORDERED_BATCHES * batch;
+    item_t* input = (item_t*)malloc(total * sizeof(item_t));
+    item_t* expect = (item_t*)malloc(total * sizeof(item_t));
+    item_t* arr = (item_t*)malloc(total * sizeof(item_t));
+    item_t* tmp = (item_t*)malloc(n * sizeof(item_t));
+    item_t* queries = (item_t*)malloc(n * sizeof(item_t));
+    check_pointer(input);
+    check_pointer(expect);
+    check_pointer(arr);
+    check_pointer(tmp);
+    check_pointer(queries);
+    generate(input, total, DIST_RANDOM, config->seed);
+    generate(queries, n, DIST_RANDOM, config->seed + 1);
+    memcpy(expect, input, total * sizeof(item_t));
+    quick_sort(expect, total);
+
+    printf("\n%d random items kept ordered under %d batches of %d inserts, then %d lookups\n", n, ORDERED_BATCHES,
+           batch, n);
+    printf("%-16s%10s%12s%10s%12s%8s\n", "method", "load(ms)", "insert(ms)", "x quick", "lookup(ns)", "check");
+    double reference = 0;
+    long expect_found = 0;
+    for (int method = 0; method < ORDERED_METHOD_COUNT; method++)
+    {
+        bool tree = method == ORDERED_BTREE_BATCH || method == ORDERED_BTREE_INSERT;
+        btree_t bt;
+        btree_init(&bt);
+        int size = n;
+
+        memcpy(arr, input, n * sizeof(item_t));
+        double start = now_ns();
+        if (tree)
+        {
+            btree_build(&bt, arr, n);
+        }
+        else
+        {
+            quick_sort(arr, n);
+        }
+        double load_time = now_ns() - start;
+
+        start = now_ns();
+        for (int b = 0; b < ORDERED_BATCHES; b++)
+        {
+            const item_t* items = input + n + b * batch;
+            if (method == ORDERED_QUICK_SORT)
+            {
+                memcpy(arr + size, items, batch * sizeof(item_t));
+                size += batch;
+                quick_sort(arr, size);
+            }
+            else if (method == ORDERED_MERGE)
+            {
+                // 批次排好序后从后向前归并进数组
+                memcpy(tmp, items, batch * sizeof(item_t));
+                quick_sort(tmp, batch);
+                int i = size - 1, j = batch - 1, k = size + batch - 1;
+                while (j >= 0)
+                {
+                    arr[k--] = i >= 0 && arr[i] > tmp[j] ? arr[i--] : tmp[j--];
+                }
+                size += batch;
+            }
+            else if (method == ORDERED_BTREE_BATCH)
+            {
+                memcpy(tmp, items, batch * sizeof(item_t));
+                btree_insert_batch(&bt, tmp, batch);
+            }
+            else
+            {
+                for (int i = 0; i < batch; i++)
+                {
+                    btree_insert(&bt, items[i]);
+                }
+            }
+        }
+        double insert_time = now_ns() - start;
+
+        long found = 0;
+        start = now_ns();
+        for (int q = 0; q < n; q++)
+        {
+            if (tree)
+            {
+                btree_iter_t it = btree_lower_bound(&bt, queries[q]);
+                found += btree_iter_valid(it) ? btree_iter_get(it) : 0;
+            }
+            else
+            {
+                int pos = search_bound(arr, size, queries[q], false);
+                found += pos < size ? arr[pos] : 0;
+            }
+        }
+        double lookup_time = (now_ns() - start) / n;
+
+        if (tree && bt.size == total)
+        {
+            size = 0;
+            for (btree_iter_t it = btree_begin(&bt); btree_iter_valid(it); btree_iter_next(&it))
+            {
+                arr[size++] = btree_iter_get(it);
+            }
+        }
+        else if (tree)
+        {
+            size = -1;
+        }
+        // 所有方法的查找结果之和应当相同
+        expect_found = method == ORDERED_QUICK_SORT ? found : expect_found;
+        bool verified = size == total && memcmp(arr, expect, total * sizeof(item_t)) == 0 && found == expect_found;
+        reference = method == ORDERED_QUICK_SORT ? insert_time : reference;
+        printf("%-16s%10.3f%12.3f%9.2fx%12.2f%8s\n", ordered_method_names[method], load_time * 1e-6,
+               insert_time * 1e-6, reference / insert_time, lookup_time, verified ? "ok" : "WRONG");
+        btree_free(&bt);
+    }
+
+    free(input);
+    free(expect);
+    free(arr);
+    free(tmp);
+    free(queries);
+}
+
+// Grid of the Dijkstra benchmark: a maze as small_game/maze.c carves it, cells of odd rows and
+// columns joined through the walls between them. A step costs the sum of the costs of its two cells,
+// so that a cell can be reached again by a shorter path and get its key decreased.
+struct grid
+{
+    int height;
+    int width;
+    bool* wall;
+    uint32_t* cost;
+};
+
+// Carve a maze with a single path between any two cells by a depth-first walk in random directions,
+// the loop form of create_map() in maze.c, then knock down `braid` of the remaining inner walls to
+// make loops, and give the cells random costs in [1, max_cost].
+static void make_grid(struct grid* g, int size, double braid, uint32_t max_cost, unsigned seed)
+{
+    int h = size % 2 ? size : size + 1;
+    int w = h;
+    int n = h * w;
+    g->height = h;
+    g->width = w;
+    g->wall = (bool*)malloc(n * sizeof(bool));
+    g->cost = (uint32_t*)malloc(n * sizeof(uint32_t));
+    int* stack = (int*)malloc(n * sizeof(int));
+    check_pointer(g->wall);
+    check_pointer(g->cost);
+    check_pointer(stack);
+    srand(seed);
+    for (int i = 0; i < n; i++)
+    {
+        g->wall[i] = true;
+        g->cost[i] = 1 + (uint32_t)rand() % max_cost;
+    }
+
+    const int dr[4] = {0, 1, 0, -1}, dc[4] = {1, 0, -1, 0};
+    int top = 0;
+    stack[top++] = w + 1;
+    g->wall[w + 1] = false;
+    while (top > 0)
+    {
+        int cell = stack[top - 1], r = cell / w, c = cell % w;
+        int options[4], count = 0;
+        for (int d = 0; d < 4; d++)
+        {
+            int r2 = r + 2 * dr[d], c2 = c + 2 * dc[d];
+            if (r2 > 0 && r2 < h - 1 && c2 > 0 && c2 < w - 1 && g->wall[r2 * w + c2])
+            {
+                options[count++] = d;
+            }
+        }
+        if (count == 0)
+        {
+            top--;
+            continue;
+        }
+        int d = options[rand() % count];
+        g->wall[(r + dr[d]) * w + c + dc[d]] = false;
+        g->wall[(r + 2 * dr[d]) * w + c + 2 * dc[d]] = false;
+        stack[top++] = (r + 2 * dr[d]) * w + c + 2 * dc[d];
+    }
+
+    // 内部墙中行列一奇一偶的是两个格子之间的墙
+    for (int r = 1; r < h - 1; r++)
+    {
+        for (int c = 1; c < w - 1; c++)
+        {
+            if (g->wall[r * w + c] && (r + c) % 2 == 1 && rand() < braid * RAND_MAX)
+            {
+                g->wall[r * w + c] = false;
+            }
+        }
+    }
+    free(stack);
+}
+
+static void free_grid(struct grid* g)
+{
+    free(g->wall);
+    free(g->cost);
+}
+
+struct dijkstra_stats
+{
+    double time;
+    long pops;
+    long decreases;
+};
+
+// Shortest distances from the top left cell to every open cell with the queue PQ, walls stay at UINT32_MAX.
+#define DEFINE_DIJKSTRA(PQ)                                                                                            \
+    static struct dijkstra_stats dijkstra_##PQ(const struct grid* g, uint32_t dist[])                                  \
+    {                                                                                                                  \
+        struct dijkstra_stats stats = {0, 0, 0};                                                                       \
+        int w = g->width, n = g->height * w;                                                                           \
+        const int step[4] = {1, -1, w, -w};                                                                            \
+        double start = now_ns();                                                                                       \
+        PQ##_t q;                                                                                                      \
+        PQ##_init(&q, n);                                                                                              \
+        for (int i = 0; i < n; i++)                                                                                    \
+        {                                                                                                              \
+            dist[i] = UINT32_MAX;                                                                                      \
+        }                                                                                                              \
+        dist[w + 1] = 0;                                                                                               \
+        PQ##_push(&q, w + 1, 0);                                                                                       \
+        while (!PQ##_empty(&q))                                                                                        \
+        {                                                                                                              \
+            uint32_t d;                                                                                                \
+            int cell = PQ##_pop(&q, &d);                                                                               \
+            stats.pops++;                                                                                              \
+            for (int k = 0; k < 4; k++)                                                                                \
+            {                                                                                                          \
+                int next = cell + step[k];                                                                             \
+                uint32_t nd = d + g->cost[cell] + g->cost[next];                                                       \
+                if (g->wall[next] || nd >= dist[next])                                                                 \
+                {                                                                                                      \
+                    continue;                                                                                          \
+                }                                                                                                      \
+                if (dist[next] == UINT32_MAX)                                                                          \
+                {                                                                                                      \
+                    PQ##_push(&q, next, nd);                                                                           \
+                }                                                                                                      \
+                else                                                                                                   \
+                {                                                                                                      \
+                    PQ##_decrease(&q, next, nd);                                                                       \
+                    stats.decreases++;                                                                                 \
+                }                                                                                                      \
+                dist[next] = nd;                                                                                       \
+            }                                                                                                          \
+        }                                                                                                              \
+        PQ##_free(&q);                                                                                                 \
+        stats.time = now_ns() - start;                                                                                 \
+        return stats;                                                                                                  \
+    }
+
+DEFINE_DIJKSTRA(dary_pq)
+DEFINE_DIJKSTRA(radix_pq)
+DEFINE_DIJKSTRA(pairing_pq)
+
+// Dijkstra from a corner of a maze, of a maze with loops and random costs, and of an open grid.
+void pqueue_test(const struct bench_config* config)
+{
+    const char* grid_names[] = {"maze", "braided maze", "open grid"};
+    const double braids[] = {0, 0.1, 1};
+    const uint32_t max_costs[] = {1, 100, 100};
+    const char* queue_names[] = {"4-ary heap", "radix heap", "pairing heap"};
+    int size = 1;
+    while ((long)size * size < config->max_size)
+    {
+        size++;
+    }
+
+    for (int k = 0; k < 3; k++)
+    {
+        struct grid g;
+        make_grid(&g, size, braids[k], max_costs[k], (unsigned)config->seed + k);
+        int n = g.height * g.width;
+        uint32_t* expect = (uint32_t*)malloc(n * sizeof(uint32_t));
+        uint32_t* dist = (uint32_t*)malloc(n * sizeof(uint32_t));
+        check_pointer(expect);
+        check_pointer(dist);
+
+        printf("\nDijkstra on a %d x %d %s\n", g.height, g.width, grid_names[k]);
+        printf("%-16s%12s%12s%12s%10s%8s\n", "queue", "time(ms)", "pops", "decreases", "x 4-ary", "check");
+        double reference = 0;
+        for (int q = 0; q < 3; q++)
+        {
+            struct dijkstra_stats stats;
+            switch (q)
+            {
+                case 0:
+                    stats = dijkstra_dary_pq(&g, expect);
+                    break;
+                case 1:
+                    stats = dijkstra_radix_pq(&g, dist);
+                    break;
+                default:
+                    stats = dijkstra_pairing_pq(&g, dist);
+                    break;
+            }
+            bool verified = q == 0 || memcmp(dist, expect, n * sizeof(uint32_t)) == 0;
+            reference = q == 0 ? stats.time : reference;
+            printf("%-16s%12.3f%12ld%12ld%9.2fx%8s\n", queue_names[q], stats.time * 1e-6, stats.pops, stats.decreases,
+                   reference / stats.time, verified ? "ok" : "WRONG");
+        }
+
+        free(expect);
+        free(dist);
+        free_grid(&g);
+    }
+}
+
+static int person_age_cmp(const void* a, const void* b)
+{
+    const struct person* p1 = a;
+    const struct person* p2 = b;
+    return (p1->age > p2->age) - (p1->age < p2->age);
+}
+
+// Sort records by a small-range key with qsort and with the stable counting sort.
+void counting_test(const struct bench_config* config)
+{
+    int n = (int)config->max_size;
+    struct person* people = (struct person*)malloc(n * sizeof(struct person));
+    struct person* work = (struct person*)malloc(n * sizeof(struct person));
+    item_t* ages = (item_t*)malloc(n * sizeof(item_t));
+    check_pointer(people);
+    check_pointer(work);
+    check_pointer(ages);
+
+    // score 记录原始位置，用来检验稳定性
+    generate(ages, n, DIST_RANDOM, config->seed);
+    for (int i = 0; i < n; i++)
+    {
+        people[i].age = (unsigned)ages[i] % 100;
+        people[i].score = i;
+        people[i].name = NULL;
+    }
+
+    memcpy(work, people, n * sizeof(struct person));
+    double start = now_ns();
+    qsort(work, n, sizeof(struct person), person_age_cmp);
+    double qsort_time = now_ns() - start;
+
+    start = now_ns();
+    bool counted = counting_sort_records(people, n, sizeof(struct person), offsetof(struct person, age), work);
+    double counting_time = now_ns() - start;
+
+    bool verified = counted;
+    for (int i = 1; i < n && verified; i++)
+    {
+        verified = work[i - 1].age < work[i].age || (work[i - 1].age == work[i].age && work[i - 1].score < work[i].score);
+    }
+    printf("\nstable counting sort of %d records by age\n", n);
+    printf("%16s%16s%10s%8s\n", "qsort(ms)", "counting(ms)", "speedup", "check");
+    printf("%16.3f%16.3f%9.2fx%8s\n", qsort_time * 1e-6, counting_time * 1e-6, qsort_time / counting_time,
+           verified ? "ok" : "WRONG");
+
+    free(people);
+    free(work);
+    free(ages);
+}
+
+static int string_cmp(const void* a, const void* b)
+{
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+// Sort user names and log keys with strcmp in qsort, with string_sort and through arena offsets.
+void string_test(const struct bench_config* config)
+{
+    int n = (int)config->max_size;
+    char* arena = (char*)malloc((size_t)n * 48);
+    uint32_t* offsets = (uint32_t*)malloc(n * sizeof(uint32_t));
+    uint32_t* order = (uint32_t*)malloc(n * sizeof(uint32_t));
+    const char** strs = (const char**)malloc(n * sizeof(const char*));
+    item_t* random_values = (item_t*)malloc(2 * n * sizeof(item_t));
+    check_pointer(arena);
+    check_pointer(offsets);
+    check_pointer(order);
+    check_pointer(strs);
+    check_pointer(random_values);
+    generate(random_values, 2 * n, DIST_RANDOM, config->seed);
+
+    const char* names_of_sets[] = {"user names", "log keys"};
+
+    printf("\nstring sort of %d strings\n", n);
+    printf("%-20s%16s%16s%16s%10s%8s\n", "strings", "qsort(ms)", "string(ms)", "arena(ms)", "speedup", "check");
+    for (int set = 0; set < 2; set++)
+    {
+        // 日志键共享很长的时间戳前缀，且重复较多
+        size_t used = 0;
+        for (int i = 0; i < n; i++)
+        {
+            unsigned r1 = (unsigned)random_values[2 * i], r2 = (unsigned)random_values[2 * i + 1];
+            offsets[i] = (uint32_t)used;
+            if (set == 0)
+            {
+                used += snprintf(arena + used, 48, "%s%x", r1 % 4 == 0 ? "user_" : "", r2) + 1;
+            }
+            else
+            {
+                used += snprintf(arena + used, 48, "2024-06-07T%02u:%02u:%02u.%03uZ svc-%u", r1 % 24 / 8, r1 % 60,
+                                 r2 % 60, r2 % 1000 / 100, r1 % 8) +
+                        1;
+            }
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            strs[i] = arena + offsets[i];
+        }
+        double start = now_ns();
+        qsort(strs, n, sizeof(const char*), string_cmp);
+        double qsort_time = now_ns() - start;
+
+        for (int i = 0; i < n; i++)
+        {
+            strs[i] = arena + offsets[i];
+        }
+        start = now_ns();
+        string_sort(strs, n);
+        double string_time = now_ns() - start;
+
+        memcpy(order, offsets, n * sizeof(uint32_t));
+        start = now_ns();
+        arena_string_sort(arena, order, n);
+        double arena_time = now_ns() - start;
+
+        bool verified = true;
+        for (int i = 1; i < n && verified; i++)
+        {
+            verified = strcmp(strs[i - 1], strs[i]) <= 0 && strcmp(arena + order[i - 1], arena + order[i]) <= 0 &&
+                       strcmp(strs[i], arena + order[i]) == 0;
+        }
+        printf("%-20s%16.3f%16.3f%16.3f%9.2fx%8s\n", names_of_sets[set], qsort_time * 1e-6, string_time * 1e-6,
+               arena_time * 1e-6, qsort_time / string_time, verified ? "ok" : "WRONG");
+    }
+
+    free(arena);
+    free(offsets);
+    free(order);
+    free(strs);
+    free(random_values);
+}
+
+void test_mode(const struct bench_config* config)
+{
+    struct bench_output out;
+    if (!bench_open(&out, config->csv_path, config->json_path))
+    {
+        return;
+    }
+
+    printf("trials: %d (+%d warmup), threads: %d, times in ns per item\n", config->trials, config->warmup, cpu_count());
+    for (long n = config->min_size; n <= config->max_size; n *= 10)
+    {
+        item_t* input = (item_t*)malloc(n * sizeof(item_t));
+        item_t* work = (item_t*)malloc(n * sizeof(item_t));
+        check_pointer(input);
+        check_pointer(work);
+
+        for (int dist = 0; dist < DIST_COUNT; dist++)
+        {
+            generate(input, n, dist, config->seed + dist);
+            checksum_t expect = checksum(input, n);
+
+            printf("\nsize: %ld, input: %s\n", n, distribution_names[dist]);
+            printf("%-22s%10s%10s%10s%10s%14s%8s%8s\n", "algorithm", "median", "p90", "min", "x quick", "peak RSS",
+                   "allocs", "check");
+
+            double reference = 0;
+            for (int i = 0; i < ALGORITHM_COUNT; i++)
+            {
+                if (n > algorithms[i].max_size)
+                {
+                    continue;
+                }
+                struct bench_record record = run_benchmark(&algorithms[i], input, work, n, expect, config);
+                record.distribution = distribution_names[dist];
+                if (algorithms[i].func == quick_sort)
+                {
+                    reference = record.ns_per_item.median;
+                }
+
+                printf("%-22s%10.2f%10.2f%10.2f%9.2fx%11ld KB%8.1f%8s\n", record.algorithm, record.ns_per_item.median,
+                       record.ns_per_item.p90, record.ns_per_item.min, reference / record.ns_per_item.median,
+                       record.peak_rss_kb, record.allocs, record.verified ? "ok" : "WRONG");
+                bench_write(&out, &record);
+            }
+        }
+
+        free(input);
+        free(work);
+    }
+    bench_close(&out);
+
+    scaling_test(config);
+    topk_test(config);
+    multikey_test(config);
+    counting_test(config);
+    inplace_merge_test(config);
+    workspace_test(config);
+    btree_test(config);
+    pqueue_test(config);
+    string_test(config);
+    type_test();
     printf("Test finished.\n");
 }
 
+// Compare auto_sort with the fastest fixed algorithm on every size and distribution.
+void auto_mode(const struct bench_config* config)
+{
+    const struct algorithm automatic = {"auto sort", auto_sort, INT_MAX};
+
+    printf("trials: %d (+%d warmup), times in ns per item\n", config->trials, config->warmup);
+    printf("%-10s%-14s%-12s%10s  %-22s%10s%10s%8s\n", "size", "input", "strategy", "auto", "best fixed", "best",
+           "x best", "check");
+    for (long n = config->min_size; n <= config->max_size; n *= 10)
+    {
+        item_t* input = (item_t*)malloc(n * sizeof(item_t));
+        item_t* work = (item_t*)malloc(n * sizeof(item_t));
+        check_pointer(input);
+        check_pointer(work);
+
+        for (int dist = 0; dist < DIST_COUNT; dist++)
+        {
+            generate(input, n, dist, config->seed + dist);
+            checksum_t expect = checksum(input, n);
+            struct sort_profile profile;
+            profile_input(input, n, &profile);
+
+            struct bench_record chosen = run_benchmark(&automatic, input, work, n, expect, config);
+            struct bench_record best = {NULL};
+            for (int i = 0; i < ALGORITHM_COUNT; i++)
+            {
+                // 只与串行的固定算法比较
+                if (n > algorithms[i].max_size || algorithms[i].func == auto_sort ||
+                    strncmp(algorithms[i].name, "parallel", 8) == 0)
+                {
+                    continue;
+                }
+                struct bench_record record = run_benchmark(&algorithms[i], input, work, n, expect, config);
+                if (best.algorithm == NULL || record.ns_per_item.median < best.ns_per_item.median)
+                {
+                    best = record;
+                }
+            }
+
+            printf("%-10ld%-14s%-12s%10.2f  %-22s%10.2f%9.2fx%8s\n", n, distribution_names[dist],
+                   strategy_names[profile.strategy], chosen.ns_per_item.median, best.algorithm,
+                   best.ns_per_item.median, best.ns_per_item.median / chosen.ns_per_item.median,
+                   chosen.verified ? "ok" : "WRONG");
+        }
+
+        free(input);
+        free(work);
+    }
+}
+
 void user_mode(void)
 {
     printf("Please select a sort algorithm:\n");
-    for (int i = 0; i < sizeof(functions) / sizeof(sort_func_t); ++i)
+    for (int i = 0; i < ALGORITHM_COUNT; ++i)
     {
-        printf("  %d: %s\n", i + 1, func_names[i]);
+        printf("  %d: %s\n", i + 1, algorithms[i].name);
     }
     int ch;
-    scanf("%d", &ch);
-    sort_func_t func = functions[ch - 1];
+    if (scanf("%d", &ch) != 1 || ch < 1 || ch > ALGORITHM_COUNT)
+    {
+        fprintf(stderr, "Invalid option.\n");
+        return;
+    }
+    sort_func_t func = algorithms[ch - 1].func;
 
     item_t arr[USER_SIZE];
     int n = 0;
@@ -128,18 +1285,163 @@ void user_mode(void)
     func(arr, n);
 
     printf("\n");
-    printf("The data after %sing is as follows:\n", func_names[ch - 1]);
+    printf("The data after %sing is as follows:\n", algorithms[ch - 1].name);
     for (int i = 0; i < n; i++)
     {
         printf("%d : %d\n", i + 1, arr[i]);
     }
 }
 
-int main(void)
+// Sort a binary file of item_t that may not fit in memory.
+int external_mode(const char* input, const char* output, long memory_mb, const char* temp_dir)
 {
+    if (temp_dir == NULL)
+    {
+        temp_dir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+    }
+    printf("External sort of %s into %s, memory: %ld MB, temp dir: %s\n", input, output, memory_mb, temp_dir);
+
+    double start = now_ns();
+    if (!external_sort(input, output, (size_t)memory_mb << 20, temp_dir))
+    {
+        return EXIT_FAILURE;
+    }
+    printf("Finished in %.3fs.\n", (now_ns() - start) * 1e-9);
+    return 0;
+}
+
+static void usage(const char* program)
+{
+    fprintf(stderr,
+            "Usage: %s [--min-size N] [--max-size N] [--trials N] [--warmup N] [--seed N] [--threads N]\n"
+            "       %*s [--csv PATH] [--json PATH] [--auto]\n"
+            "       %s --external INPUT OUTPUT [--memory MB] [--tmp DIR]\n"
+            "--auto compares auto_sort with the best fixed algorithm instead of running all the tests.\n"
+            "Without options an interactive menu is shown.\n",
+            program, (int)strlen(program), "", program);
+}
+
+static int external_main(int argc, char* argv[])
+{
+    if (argc < 4)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    long memory_mb = DEFAULT_MEMORY_MB;
+    const char* temp_dir = NULL;
+    for (int i = 4; i < argc; i += 2)
+    {
+        if (i + 1 < argc && strcmp(argv[i], "--memory") == 0)
+        {
+            memory_mb = atol(argv[i + 1]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--tmp") == 0)
+        {
+            temp_dir = argv[i + 1];
+        }
+        else
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (memory_mb < 1)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    return external_mode(argv[2], argv[3], memory_mb, temp_dir);
+}
+
+int main(int argc, char* argv[])
+{
+    struct bench_config config = {
+        DEFAULT_MIN_SIZE, DEFAULT_MAX_SIZE, DEFAULT_TRIALS, DEFAULT_WARMUP, DEFAULT_SEED, NULL, NULL, cpu_count()};
+
+    if (argc > 1 && strcmp(argv[1], "--external") == 0)
+    {
+        return external_main(argc, argv);
+    }
+
+    // 带参数时直接以非交互方式运行测试模式
+    if (argc > 1)
+    {
+        bool automatic = false;
+        for (int i = 1; i < argc; i++)
+        {
+            if (strcmp(argv[i], "--auto") == 0)
+            {
+                automatic = true;
+                continue;
+            }
+            const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+            if (value == NULL)
+            {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            if (strcmp(argv[i], "--min-size") == 0)
+            {
+                config.min_size = atol(value);
+            }
+            else if (strcmp(argv[i], "--max-size") == 0)
+            {
+                config.max_size = atol(value);
+            }
+            else if (strcmp(argv[i], "--trials") == 0)
+            {
+                config.trials = atoi(value);
+            }
+            else if (strcmp(argv[i], "--warmup") == 0)
+            {
+                config.warmup = atoi(value);
+            }
+            else if (strcmp(argv[i], "--seed") == 0)
+            {
+                config.seed = strtoull(value, NULL, 10);
+            }
+            else if (strcmp(argv[i], "--threads") == 0)
+            {
+                config.threads = atoi(value);
+            }
+            else if (strcmp(argv[i], "--csv") == 0)
+            {
+                config.csv_path = value;
+            }
+            else if (strcmp(argv[i], "--json") == 0)
+            {
+                config.json_path = value;
+            }
+            else
+            {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            i++;
+        }
+        if (config.min_size < 1 || config.max_size > INT_MAX || config.trials < 1 || config.warmup < 0 ||
+            config.threads < 1 || config.threads > 1024)
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        if (automatic)
+        {
+            auto_mode(&config);
+        }
+        else
+        {
+            test_mode(&config);
+        }
+        return 0;
+    }
+
     printf("Please select:\n");
     printf("  1. Test mode. (default)\n");
     printf("  2. User mode.\n");
+    printf("  3. External mode.\n");
+    printf("  4. Auto mode.\n");
 
     char ch;
     scanf("%c", &ch);
@@ -147,11 +1449,25 @@ int main(void)
     {
         case '1':
         case '\n':
-            test_mode();
+            test_mode(&config);
             break;
         case '2':
             user_mode();
             break;
+        case '3':
+        {
+            char input[1024], output[1024];
+            printf("Please input the file to sort and the output file:\n");
+            if (scanf("%1023s %1023s", input, output) != 2)
+            {
+                fprintf(stderr, "Invalid input.\n");
+                return EXIT_FAILURE;
+            }
+            return external_mode(input, output, DEFAULT_MEMORY_MB, NULL);
+        }
+        case '4':
+            auto_mode(&config);
+            break;
         default:
             fprintf(stderr, "Invalid option.\n");
             break;
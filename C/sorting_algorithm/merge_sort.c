@@ -28,8 +28,9 @@ static inline void merge(item_t arr[], int start, int median, int stop, item_t s
 
 static inline void sort(item_t arr[], int start, int stop, item_t space[])
 {
-    if (stop - start <= 1)
+    if (stop - start <= SIMD_SORT_MAX)
     {
+        simd_small_sort(arr + start, stop - start);
         return;
     }
 
@@ -39,12 +40,18 @@ static inline void sort(item_t arr[], int start, int stop, item_t space[])
     merge(arr, start, median, stop, space); // merge [start, stop)
 }
 
-void merge_sort(item_t arr[], int n)
+void merge_sort_ws(item_t arr[], int n, sort_workspace_t* ws)
 {
-    item_t* space = (item_t*)malloc(n * sizeof(item_t));
-    check_pointer(space);
+    // 左半段最多 n / 2 + 1 个元素
+    item_t* space = (item_t*)sort_workspace_reserve(ws, (n / 2 + 1) * sizeof(item_t));
 
     sort(arr, 0, n, space);
+}
 
-    free(space);
+void merge_sort(item_t arr[], int n)
+{
+    sort_workspace_t ws;
+    sort_workspace_init(&ws, 0);
+    merge_sort_ws(arr, n, &ws);
+    sort_workspace_free(&ws);
 }
@@ -0,0 +1,116 @@
+#include "pqueue.h"
+
+// Make the root with the larger priority the first child of the other, return the new root.
+static inline int meld(pairing_node_t nodes[], int a, int b)
+{
+    if (nodes[b].priority < nodes[a].priority)
+    {
+        int tmp = a;
+        a = b;
+        b = tmp;
+    }
+    int first = nodes[a].child;
+    nodes[b].sibling = first;
+    nodes[b].prev = a;
+    if (first >= 0)
+    {
+        nodes[first].prev = b;
+    }
+    nodes[a].child = b;
+    return a;
+}
+
+void pairing_pq_init(pairing_pq_t* q, int capacity)
+{
+    q->nodes = (pairing_node_t*)sort_malloc(capacity * sizeof(pairing_node_t));
+    q->pairs = (int*)sort_malloc(capacity * sizeof(int));
+    for (int i = 0; i < capacity; i++)
+    {
+        q->nodes[i].prev = -1;
+    }
+    q->root = -1;
+    q->size = 0;
+}
+
+void pairing_pq_free(pairing_pq_t* q)
+{
+    free(q->nodes);
+    free(q->pairs);
+}
+
+void pairing_pq_push(pairing_pq_t* q, int id, uint32_t priority)
+{
+    pairing_node_t* node = &q->nodes[id];
+    node->priority = priority;
+    node->child = -1;
+    node->sibling = -1;
+    node->prev = -1;
+    q->root = q->root < 0 ? id : meld(q->nodes, q->root, id);
+    q->size++;
+}
+
+int pairing_pq_pop(pairing_pq_t* q, uint32_t* priority)
+{
+    pairing_node_t* nodes = q->nodes;
+    int top = q->root;
+    *priority = nodes[top].priority;
+
+    // 两趟配对：从左到右两两合并，再从右到左依次合并到一起
+    int count = 0;
+    for (int c = nodes[top].child; c >= 0;)
+    {
+        int next = nodes[c].sibling;
+        nodes[c].sibling = -1;
+        nodes[c].prev = -1;
+        if (next >= 0)
+        {
+            int after = nodes[next].sibling;
+            nodes[next].sibling = -1;
+            nodes[next].prev = -1;
+            q->pairs[count++] = meld(nodes, c, next);
+            c = after;
+        }
+        else
+        {
+            q->pairs[count++] = c;
+            c = -1;
+        }
+    }
+    int root = count > 0 ? q->pairs[count - 1] : -1;
+    for (int i = count - 2; i >= 0; i--)
+    {
+        root = meld(nodes, q->pairs[i], root);
+    }
+
+    q->root = root;
+    q->size--;
+    return top;
+}
+
+void pairing_pq_decrease(pairing_pq_t* q, int id, uint32_t priority)
+{
+    pairing_node_t* nodes = q->nodes;
+    nodes[id].priority = priority;
+    if (id == q->root)
+    {
+        return;
+    }
+
+    // 把以 id 为根的子树剪下来，再与根合并
+    int prev = nodes[id].prev, next = nodes[id].sibling;
+    if (nodes[prev].child == id)
+    {
+        nodes[prev].child = next;
+    }
+    else
+    {
+        nodes[prev].sibling = next;
+    }
+    if (next >= 0)
+    {
+        nodes[next].prev = prev;
+    }
+    nodes[id].sibling = -1;
+    nodes[id].prev = -1;
+    q->root = meld(nodes, q->root, id);
+}
@@ -0,0 +1,169 @@
+#include "loser_tree.h"
+#include "sort.h"
+#include "thread_pool.h"
+
+#include <limits.h>
+
+// Parallel stable merge sort: every thread sorts one block with tim_sort, then the output is cut
+// into equal pieces and each thread merges its piece from all the blocks at once through a loser
+// tree. Co-ranking finds where a piece starts in every block, so the pieces have exactly the same
+// size whatever the data, and ties always go to the lower block, which keeps the sort stable.
+
+// Inputs smaller than this are sorted serially.
+#define MERGE_SORT_THRESHOLD 65536
+
+struct merge_sort
+{
+    item_t* arr;
+    item_t* space;
+    int n;
+    int blocks;
+};
+
+static inline int block_begin(const struct merge_sort* m, int block)
+{
+    return (int)((long)m->n * block / m->blocks);
+}
+
+// First position in arr[begin, end) whose item is not less (or, if `upper`, greater) than x.
+static inline int search(const item_t arr[], int begin, int end, long x, bool upper)
+{
+    while (begin < end)
+    {
+        int mid = begin + (end - begin) / 2;
+        if (upper ? arr[mid] <= x : arr[mid] < x)
+        {
+            begin = mid + 1;
+        }
+        else
+        {
+            end = mid;
+        }
+    }
+    return begin;
+}
+
+// Split the sorted blocks so that the `rank` smallest items of the merge are exactly the items
+// before split[b] of every block b.
+static void co_rank(const struct merge_sort* m, long rank, int split[])
+{
+    if (rank == 0)
+    {
+        for (int b = 0; b < m->blocks; b++)
+        {
+            split[b] = block_begin(m, b);
+        }
+        return;
+    }
+
+    // 在值域上二分：找最小的 v 使得不大于 v 的元素个数至少为 rank
+    long lo = INT_MIN, hi = INT_MAX;
+    while (lo < hi)
+    {
+        long mid = lo + (hi - lo) / 2;
+        long count = 0;
+        for (int b = 0; b < m->blocks; b++)
+        {
+            count += search(m->arr, block_begin(m, b), block_begin(m, b + 1), mid, true) - block_begin(m, b);
+        }
+        if (count >= rank)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+
+    // 小于 v 的全部取走，剩下的名额按块号顺序分给等于 v 的元素
+    long remaining = rank;
+    for (int b = 0; b < m->blocks; b++)
+    {
+        split[b] = search(m->arr, block_begin(m, b), block_begin(m, b + 1), lo, false);
+        remaining -= split[b] - block_begin(m, b);
+    }
+    for (int b = 0; b < m->blocks && remaining > 0; b++)
+    {
+        int equal = search(m->arr, split[b], block_begin(m, b + 1), lo, true) - split[b];
+        int take = remaining < equal ? (int)remaining : equal;
+        split[b] += take;
+        remaining -= take;
+    }
+}
+
+static void sort_block(void* context, int block)
+{
+    struct merge_sort* m = (struct merge_sort*)context;
+    int begin = block_begin(m, block);
+    tim_sort(m->arr + begin, block_begin(m, block + 1) - begin);
+}
+
+// Merge the items of output piece `piece` from all the blocks into space.
+static void merge_piece(void* context, int piece)
+{
+    struct merge_sort* m = (struct merge_sort*)context;
+    int k = m->blocks;
+    int* pos = (int*)sort_malloc(2 * k * sizeof(int));
+    int* end = pos + k;
+    co_rank(m, block_begin(m, piece), pos);
+    co_rank(m, block_begin(m, piece + 1), end);
+
+    loser_tree_t lt;
+    loser_tree_init(&lt, k);
+    for (int b = 0; b < k; b++)
+    {
+        lt.done[b] = pos[b] == end[b];
+        lt.key[b] = lt.done[b] ? 0 : m->arr[pos[b]];
+    }
+    loser_tree_build(&lt);
+
+    item_t* out = m->space + block_begin(m, piece);
+    item_t* stop = m->space + block_begin(m, piece + 1);
+    while (out < stop)
+    {
+        int b = loser_tree_top(&lt);
+        *out++ = lt.key[b];
+        if (++pos[b] == end[b])
+        {
+            lt.done[b] = true;
+        }
+        else
+        {
+            lt.key[b] = m->arr[pos[b]];
+        }
+        loser_tree_replay(&lt, b);
+    }
+
+    loser_tree_free(&lt);
+    free(pos);
+}
+
+static void copy_piece(void* context, int piece)
+{
+    struct merge_sort* m = (struct merge_sort*)context;
+    int begin = block_begin(m, piece);
+    memcpy(m->arr + begin, m->space + begin, (block_begin(m, piece + 1) - begin) * sizeof(item_t));
+}
+
+void parallel_merge_sort(item_t arr[], int n, int threads)
+{
+    if (threads <= 0)
+    {
+        threads = cpu_count();
+    }
+    if (threads == 1 || n <= MERGE_SORT_THRESHOLD)
+    {
+        tim_sort(arr, n);
+        return;
+    }
+
+    struct merge_sort m = {arr, NULL, n, threads};
+    m.space = (item_t*)sort_malloc(n * sizeof(item_t));
+
+    pool_for(threads, m.blocks, sort_block, &m);
+    pool_for(threads, m.blocks, merge_piece, &m);
+    pool_for(threads, m.blocks, copy_piece, &m);
+
+    free(m.space);
+}
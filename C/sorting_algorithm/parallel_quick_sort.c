@@ -0,0 +1,89 @@
+#include "sort.h"
+#include "thread_pool.h"
+
+// Partitions smaller than this are sorted serially by the worker that owns them.
+#define PARALLEL_THRESHOLD 16384
+
+// Median-of-three Hoare partition, returns the final position of the pivot.
+static inline int partition(item_t arr[], int n)
+{
+    int mid = n / 2;
+    if (arr[mid] < arr[0])
+    {
+        swap(&arr[mid], &arr[0]);
+    }
+    if (arr[n - 1] < arr[0])
+    {
+        swap(&arr[n - 1], &arr[0]);
+    }
+    if (arr[n - 1] < arr[mid])
+    {
+        swap(&arr[n - 1], &arr[mid]);
+    }
+    swap(&arr[0], &arr[mid]); // arr[0] is the pivot and arr[n - 1] >= pivot stops the left scan
+
+    item_t pivot = arr[0];
+    int i = 0, j = n;
+    while (true)
+    {
+        do
+        {
+            i++;
+        } while (arr[i] < pivot);
+        do
+        {
+            j--;
+        } while (pivot < arr[j]);
+        if (i >= j)
+        {
+            break;
+        }
+        swap(&arr[i], &arr[j]);
+    }
+    swap(&arr[0], &arr[j]);
+    return j;
+}
+
+static void sort_task(worker_t* self, task_t task)
+{
+    item_t* arr = task.arr;
+    int n = task.n;
+
+    // Spawn the left part for thieves and keep splitting the right part locally.
+    while (n > PARALLEL_THRESHOLD && task.depth > 0)
+    {
+        int p = partition(arr, n);
+        task.depth--;
+
+        task_t left = task;
+        left.arr = arr;
+        left.n = p;
+        pool_spawn(self, left);
+
+        arr += p + 1;
+        n -= p + 1;
+    }
+    quick_sort(arr, n);
+}
+
+void parallel_quick_sort(item_t arr[], int n, int threads)
+{
+    if (threads <= 0)
+    {
+        threads = cpu_count();
+    }
+    if (threads == 1 || n <= PARALLEL_THRESHOLD)
+    {
+        quick_sort(arr, n);
+        return;
+    }
+
+    int depth = 0;
+    for (int i = n; i > 0; i >>= 1)
+    {
+        depth += 2;
+    }
+
+    task_t root = {sort_task, arr, n, depth, NULL};
+    pool_run(threads, root);
+}
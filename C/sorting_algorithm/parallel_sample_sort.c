@@ -0,0 +1,172 @@
+#include "sort.h"
+#include "thread_pool.h"
+
+// Parallel super scalar sample sort: splitters picked from a sorted oversample form a branchless
+// search tree, every thread classifies and scatters a block of the input into the buckets,
+// then the buckets are sorted in parallel. Keys equal to a splitter go to an equality bucket
+// that needs no sorting, so inputs with many duplicates stay balanced.
+
+// Inputs smaller than this are sorted serially.
+#define SAMPLE_SORT_THRESHOLD 65536
+
+// Largest number of ordinary buckets, a power of two.
+#define MAX_BUCKETS 256
+
+// Sample items per bucket.
+#define OVERSAMPLING 16
+
+struct sample_sort
+{
+    item_t* arr;
+    item_t* space;
+    uint16_t* oracle; // bucket of every item
+    int n;
+    int blocks;
+    int log_buckets;
+    int buckets;              // ordinary buckets, bucket 2 * b + 1 holds the items equal to splitters[b]
+    item_t tree[MAX_BUCKETS]; // splitters in breadth-first order, root at 1
+    item_t splitters[MAX_BUCKETS];
+    int* counts; // counts[block * 2 * buckets + bucket], turned into scatter offsets
+    int* bucket_start;
+};
+
+static inline int block_begin(const struct sample_sort* s, int block)
+{
+    return (int)((long)s->n * block / s->blocks);
+}
+
+// Fill the subtree at node j with sorted[i, ...) in order, return the next index.
+static int build_tree(item_t tree[], int j, int k, const item_t sorted[], int i)
+{
+    if (j >= k)
+    {
+        return i;
+    }
+    i = build_tree(tree, 2 * j, k, sorted, i);
+    tree[j] = sorted[i++];
+    return build_tree(tree, 2 * j + 1, k, sorted, i);
+}
+
+static inline int classify(const struct sample_sort* s, item_t x)
+{
+    int j = 1;
+    for (int level = 0; level < s->log_buckets; level++)
+    {
+        j = 2 * j + (x > s->tree[j]); // 无分支：比较结果直接参与下标计算
+    }
+    int b = j - s->buckets; // 小于 x 的分割元个数
+    return 2 * b + (b < s->buckets - 1 && x == s->splitters[b]);
+}
+
+static void classify_block(void* context, int block)
+{
+    struct sample_sort* s = (struct sample_sort*)context;
+    int* count = s->counts + block * 2 * s->buckets;
+    for (int i = block_begin(s, block), end = block_begin(s, block + 1); i < end; i++)
+    {
+        int b = classify(s, s->arr[i]);
+        s->oracle[i] = (uint16_t)b;
+        count[b]++;
+    }
+}
+
+static void scatter_block(void* context, int block)
+{
+    struct sample_sort* s = (struct sample_sort*)context;
+    int* offset = s->counts + block * 2 * s->buckets;
+    for (int i = block_begin(s, block), end = block_begin(s, block + 1); i < end; i++)
+    {
+        s->space[offset[s->oracle[i]]++] = s->arr[i];
+    }
+}
+
+// Copy a bucket back into place and sort it, equality buckets are already sorted.
+static void sort_bucket(void* context, int bucket)
+{
+    struct sample_sort* s = (struct sample_sort*)context;
+    int begin = s->bucket_start[bucket], size = s->bucket_start[bucket + 1] - begin;
+    memcpy(s->arr + begin, s->space + begin, size * sizeof(item_t));
+    if (bucket % 2 == 0)
+    {
+        quick_sort(s->arr + begin, size);
+    }
+}
+
+static inline uint64_t splitmix64(uint64_t* state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+void parallel_sample_sort(item_t arr[], int n, int threads)
+{
+    if (threads <= 0)
+    {
+        threads = cpu_count();
+    }
+    if (threads == 1 || n <= SAMPLE_SORT_THRESHOLD)
+    {
+        quick_sort(arr, n);
+        return;
+    }
+
+    struct sample_sort s;
+    s.arr = arr;
+    s.n = n;
+    s.blocks = threads;
+    s.log_buckets = 1;
+    while ((1 << s.log_buckets) < 4 * threads && (1 << s.log_buckets) < MAX_BUCKETS)
+    {
+        s.log_buckets++;
+    }
+    s.buckets = 1 << s.log_buckets;
+
+    // 固定种子的过采样，结果可复现
+    int sample_size = s.buckets * OVERSAMPLING;
+    item_t* sample = (item_t*)sort_malloc(sample_size * sizeof(item_t));
+    uint64_t state = 0x5A3C;
+    for (int i = 0; i < sample_size; i++)
+    {
+        sample[i] = arr[splitmix64(&state) % n];
+    }
+    quick_sort(sample, sample_size);
+    for (int i = 0; i < s.buckets - 1; i++)
+    {
+        s.splitters[i] = sample[(i + 1) * OVERSAMPLING - 1];
+    }
+    build_tree(s.tree, 1, s.buckets, s.splitters, 0);
+    free(sample);
+
+    int total = 2 * s.buckets;
+    s.space = (item_t*)sort_malloc(n * sizeof(item_t));
+    s.oracle = (uint16_t*)sort_malloc(n * sizeof(uint16_t));
+    s.counts = (int*)sort_malloc(s.blocks * total * sizeof(int));
+    s.bucket_start = (int*)sort_malloc((total + 1) * sizeof(int));
+    memset(s.counts, 0, s.blocks * total * sizeof(int));
+
+    pool_for(threads, s.blocks, classify_block, &s);
+
+    // 桶号优先、块号其次做前缀和，得到每个块在每个桶中的写入位置
+    int sum = 0;
+    for (int b = 0; b < total; b++)
+    {
+        s.bucket_start[b] = sum;
+        for (int block = 0; block < s.blocks; block++)
+        {
+            int c = s.counts[block * total + b];
+            s.counts[block * total + b] = sum;
+            sum += c;
+        }
+    }
+    s.bucket_start[total] = sum;
+
+    pool_for(threads, s.blocks, scatter_block, &s);
+    pool_for(threads, total - 1, sort_bucket, &s);
+
+    free(s.space);
+    free(s.oracle);
+    free(s.counts);
+    free(s.bucket_start);
+}
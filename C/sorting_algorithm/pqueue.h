@@ -0,0 +1,116 @@
+#ifndef PQUEUE_H
+#define PQUEUE_H
+
+#include "sort.h"
+
+// Min-priority queues of ids in [0, capacity), each id in the queue at most once. They share one API:
+//
+//   X_init(q, capacity), X_free(q)
+//   X_empty(q), X_contains(q, id)
+//   X_push(q, id, priority)        id must not be in the queue
+//   X_pop(q, &priority)            remove the id of the smallest priority and return it
+//   X_decrease(q, id, priority)    lower the priority of an id in the queue
+//
+// dary_pq is a 4-ary heap with the position of every id, the sift-down of heap_sort() made usable
+// on its own. radix_pq only takes priorities not below the last one popped, as in Dijkstra's
+// algorithm, and keeps them in buckets by the highest bit they differ from it in. pairing_pq is a
+// pairing heap, whose decrease-key is a cut and a meld.
+
+typedef struct
+{
+    uint32_t priority;
+    int id;
+} pq_entry_t;
+
+// Children per node of dary_pq.
+#define DARY_PQ_D 4
+
+typedef struct
+{
+    pq_entry_t* heap;
+    int* pos; // index of every id in heap, -1 when absent
+    int size;
+} dary_pq_t;
+
+void dary_pq_init(dary_pq_t* q, int capacity);
+void dary_pq_free(dary_pq_t* q);
+void dary_pq_push(dary_pq_t* q, int id, uint32_t priority);
+int dary_pq_pop(dary_pq_t* q, uint32_t* priority);
+void dary_pq_decrease(dary_pq_t* q, int id, uint32_t priority);
+
+static inline bool dary_pq_empty(const dary_pq_t* q)
+{
+    return q->size == 0;
+}
+
+static inline bool dary_pq_contains(const dary_pq_t* q, int id)
+{
+    return q->pos[id] >= 0;
+}
+
+// Bucket 0 holds the priorities equal to the last one popped, bucket b those whose highest bit
+// differing from it is bit b - 1.
+#define RADIX_PQ_BUCKETS 33
+
+typedef struct
+{
+    pq_entry_t* bucket[RADIX_PQ_BUCKETS];
+    int size[RADIX_PQ_BUCKETS];
+    int capacity[RADIX_PQ_BUCKETS];
+    int* where; // bucket of every id, -1 when absent
+    int* pos;   // index of every id in its bucket
+    uint32_t last;
+    int count;
+} radix_pq_t;
+
+void radix_pq_init(radix_pq_t* q, int capacity);
+void radix_pq_free(radix_pq_t* q);
+void radix_pq_push(radix_pq_t* q, int id, uint32_t priority);
+int radix_pq_pop(radix_pq_t* q, uint32_t* priority);
+void radix_pq_decrease(radix_pq_t* q, int id, uint32_t priority);
+
+static inline bool radix_pq_empty(const radix_pq_t* q)
+{
+    return q->count == 0;
+}
+
+static inline bool radix_pq_contains(const radix_pq_t* q, int id)
+{
+    return q->where[id] >= 0;
+}
+
+// Node of every id, linked by ids, -1 for none. `prev` is the parent of a first child and the
+// left sibling of the others.
+typedef struct
+{
+    uint32_t priority;
+    int child;
+    int sibling;
+    int prev;
+} pairing_node_t;
+
+typedef struct
+{
+    pairing_node_t* nodes;
+    int* pairs; // trees of the pairing passes of a pop
+    int root;
+    int size;
+} pairing_pq_t;
+
+void pairing_pq_init(pairing_pq_t* q, int capacity);
+void pairing_pq_free(pairing_pq_t* q);
+void pairing_pq_push(pairing_pq_t* q, int id, uint32_t priority);
+int pairing_pq_pop(pairing_pq_t* q, uint32_t* priority);
+void pairing_pq_decrease(pairing_pq_t* q, int id, uint32_t priority);
+
+static inline bool pairing_pq_empty(const pairing_pq_t* q)
+{
+    return q->size == 0;
+}
+
+static inline bool pairing_pq_contains(const pairing_pq_t* q, int id)
+{
+    return id == q->root || q->nodes[id].prev >= 0;
+}
+
+#endif // PQUEUE_H
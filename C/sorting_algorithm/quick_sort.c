@@ -1,38 +1,246 @@
 #include "sort.h"
 
-static inline void sort(item_t arr[], int left, int right)
+// Pattern-defeating quick sort: introsort with ninther pivots, equal-key grouping, sorted-run detection
+// and sorting-network leaves.
+
+// Ranges smaller than this are not worth breaking patterns in.
+#define PATTERN_BREAK_THRESHOLD 24
+
+// Sub-arrays larger than this choose the pivot with Tukey's ninther instead of median-of-three.
+#define NINTHER_THRESHOLD 128
+
+// Give up the optimistic insertion sort of an already partitioned range after this many moves.
+#define PARTIAL_INSERTION_SORT_LIMIT 8
+
+static inline void sort3(item_t* a, item_t* b, item_t* c)
+{
+    if (*b < *a)
+    {
+        swap(a, b);
+    }
+    if (*c < *b)
+    {
+        swap(b, c);
+    }
+    if (*b < *a)
+    {
+        swap(a, b);
+    }
+}
+
+// Insertion sort that gives up once it has moved too many elements, returns whether the range got sorted.
+static inline bool partial_insertion_sort(item_t* begin, item_t* end)
 {
-    if (left < right)
+    int moved = 0;
+    for (item_t* cur = begin + 1; cur < end; cur++)
     {
-        swap(&arr[left], &arr[(left + right) / 2]);
-        int i = left, j = right, pivot = arr[left];
-        while (i < j)
+        item_t tmp = *cur;
+        item_t* sift = cur;
+        for (; sift > begin && tmp < sift[-1]; sift--)
         {
-            while (i < j && arr[j] > pivot)
-            {
-                j--;
-            }
-            if (i < j)
-            {
-                arr[i++] = arr[j];
-            }
+            *sift = sift[-1];
+        }
+        *sift = tmp;
 
-            while (i < j && arr[i] < pivot)
-            {
-                i++;
-            }
-            if (i < j)
+        moved += cur - sift;
+        if (moved > PARTIAL_INSERTION_SORT_LIMIT)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Partition around *begin, elements equal to the pivot go left. Used when the pivot equals the left
+// neighbour of the range, so the whole equal group ends up in place and is never visited again.
+static inline item_t* partition_left(item_t* begin, item_t* end)
+{
+    item_t pivot = *begin;
+    item_t* first = begin;
+    item_t* last = end;
+
+    while (pivot < *--last)
+        ;
+    if (last + 1 == end)
+    {
+        while (first < last && !(pivot < *++first))
+            ;
+    }
+    else
+    {
+        while (!(pivot < *++first))
+            ;
+    }
+
+    while (first < last)
+    {
+        swap(first, last);
+        while (pivot < *--last)
+            ;
+        while (!(pivot < *++first))
+            ;
+    }
+
+    *begin = *last;
+    *last = pivot;
+    return last;
+}
+
+// Partition around *begin, elements equal to the pivot go right.
+// Sets `partitioned` if no element had to be swapped, which hints that the input is already sorted.
+static inline item_t* partition_right(item_t* begin, item_t* end, bool* partitioned)
+{
+    item_t pivot = *begin;
+    item_t* first = begin;
+    item_t* last = end;
+
+    while (*++first < pivot)
+        ;
+    if (first - 1 == begin)
+    {
+        while (first < last && !(*--last < pivot))
+            ;
+    }
+    else
+    {
+        while (!(*--last < pivot))
+            ;
+    }
+
+    *partitioned = first >= last;
+    while (first < last)
+    {
+        swap(first, last);
+        while (*++first < pivot)
+            ;
+        while (!(*--last < pivot))
+            ;
+    }
+
+    item_t* pivot_pos = first - 1;
+    *begin = *pivot_pos;
+    *pivot_pos = pivot;
+    return pivot_pos;
+}
+
+// Swap a few elements into new positions to break up patterns that keep producing bad partitions.
+static inline void break_patterns(item_t* begin, item_t* end)
+{
+    int size = end - begin;
+    if (size >= PATTERN_BREAK_THRESHOLD)
+    {
+        swap(begin, begin + size / 4);
+        swap(end - 1, end - size / 4);
+        if (size > NINTHER_THRESHOLD)
+        {
+            swap(begin + 1, begin + (size / 4 + 1));
+            swap(begin + 2, begin + (size / 4 + 2));
+            swap(end - 2, end - (size / 4 + 1));
+            swap(end - 3, end - (size / 4 + 2));
+        }
+    }
+}
+
+static void sort(item_t* begin, item_t* end, int bad_allowed, bool leftmost)
+{
+    while (true)
+    {
+        int size = end - begin;
+        if (size <= SIMD_SORT_MAX)
+        {
+            simd_small_sort(begin, size);
+            return;
+        }
+
+        // 选取枢轴并放到 begin
+        int half = size / 2;
+        if (size > NINTHER_THRESHOLD)
+        {
+            sort3(begin, begin + half, end - 1);
+            sort3(begin + 1, begin + (half - 1), end - 2);
+            sort3(begin + 2, begin + (half + 1), end - 3);
+            sort3(begin + (half - 1), begin + half, begin + (half + 1));
+            swap(begin, begin + half);
+        }
+        else
+        {
+            sort3(begin + half, begin, end - 1);
+        }
+
+        // 枢轴与左邻元素相等：所有等于枢轴的元素已就位，只需处理右侧
+        if (!leftmost && !(begin[-1] < *begin))
+        {
+            begin = partition_left(begin, end) + 1;
+            continue;
+        }
+
+        bool partitioned;
+        item_t* pivot_pos = partition_right(begin, end, &partitioned);
+        int left_size = pivot_pos - begin;
+        int right_size = end - (pivot_pos + 1);
+
+        if (left_size < size / 8 || right_size < size / 8)
+        {
+            // 划分严重失衡次数过多：退化为堆排序以保证 O(n log n)
+            if (--bad_allowed == 0)
             {
-                arr[j--] = arr[i];
+                heap8_sort(begin, size);
+                return;
             }
+            break_patterns(begin, pivot_pos);
+            break_patterns(pivot_pos + 1, end);
         }
-        arr[i] = pivot;
-        sort(arr, left, i - 1);
-        sort(arr, i + 1, right);
+        else if (partitioned && partial_insertion_sort(begin, pivot_pos) && partial_insertion_sort(pivot_pos + 1, end))
+        {
+            return;
+        }
+
+        sort(begin, pivot_pos, bad_allowed, leftmost);
+        begin = pivot_pos + 1;
+        leftmost = false;
     }
 }
 
 void quick_sort(item_t arr[], int n)
 {
-    sort(arr, 0, n - 1);
+    if (n < 2)
+    {
+        return;
+    }
+
+    // 整体已有序或严格逆序时线性完成
+    int run = 1;
+    if (arr[1] < arr[0])
+    {
+        while (run < n && arr[run] < arr[run - 1])
+        {
+            run++;
+        }
+        if (run == n)
+        {
+            for (int i = 0, j = n - 1; i < j; i++, j--)
+            {
+                swap(&arr[i], &arr[j]);
+            }
+            return;
+        }
+    }
+    else
+    {
+        while (run < n && !(arr[run] < arr[run - 1]))
+        {
+            run++;
+        }
+        if (run == n)
+        {
+            return;
+        }
+    }
+
+    int bad_allowed = 0;
+    for (int i = n; i > 1; i >>= 1)
+    {
+        bad_allowed++;
+    }
+    sort(arr, arr + n, bad_allowed, true);
 }
@@ -0,0 +1,96 @@
+#include "pqueue.h"
+
+static inline int bucket_of(uint32_t priority, uint32_t last)
+{
+    return priority == last ? 0 : 32 - __builtin_clz(priority ^ last);
+}
+
+static inline void bucket_push(radix_pq_t* q, int b, pq_entry_t e)
+{
+    if (q->size[b] == q->capacity[b])
+    {
+        q->capacity[b] = q->capacity[b] ? 2 * q->capacity[b] : 16;
+        q->bucket[b] = (pq_entry_t*)realloc(q->bucket[b], q->capacity[b] * sizeof(pq_entry_t));
+        check_pointer(q->bucket[b]);
+    }
+    q->where[e.id] = b;
+    q->pos[e.id] = q->size[b];
+    q->bucket[b][q->size[b]++] = e;
+}
+
+// Remove the entry at i of bucket b by moving the last entry there.
+static inline void bucket_remove(radix_pq_t* q, int b, int i)
+{
+    pq_entry_t moved = q->bucket[b][--q->size[b]];
+    q->bucket[b][i] = moved;
+    q->pos[moved.id] = i;
+}
+
+void radix_pq_init(radix_pq_t* q, int capacity)
+{
+    memset(q->bucket, 0, sizeof(q->bucket));
+    memset(q->size, 0, sizeof(q->size));
+    memset(q->capacity, 0, sizeof(q->capacity));
+    q->where = (int*)sort_malloc(capacity * sizeof(int));
+    q->pos = (int*)sort_malloc(capacity * sizeof(int));
+    memset(q->where, -1, capacity * sizeof(int));
+    q->last = 0;
+    q->count = 0;
+}
+
+void radix_pq_free(radix_pq_t* q)
+{
+    for (int b = 0; b < RADIX_PQ_BUCKETS; b++)
+    {
+        free(q->bucket[b]);
+    }
+    free(q->where);
+    free(q->pos);
+}
+
+void radix_pq_push(radix_pq_t* q, int id, uint32_t priority)
+{
+    pq_entry_t e = {priority, id};
+    bucket_push(q, bucket_of(priority, q->last), e);
+    q->count++;
+}
+
+int radix_pq_pop(radix_pq_t* q, uint32_t* priority)
+{
+    if (q->size[0] == 0)
+    {
+        // 第一个非空桶的最小值成为新的 last，桶里其余元素与它的最高不同位都更低，分散到更小的桶
+        int b = 1;
+        while (q->size[b] == 0)
+        {
+            b++;
+        }
+        pq_entry_t* entries = q->bucket[b];
+        uint32_t min = entries[0].priority;
+        for (int i = 1; i < q->size[b]; i++)
+        {
+            min = entries[i].priority < min ? entries[i].priority : min;
+        }
+        q->last = min;
+        int n = q->size[b];
+        q->size[b] = 0;
+        for (int i = 0; i < n; i++)
+        {
+            bucket_push(q, bucket_of(entries[i].priority, min), entries[i]);
+        }
+    }
+
+    pq_entry_t top = q->bucket[0][--q->size[0]];
+    q->where[top.id] = -1;
+    q->count--;
+    *priority = top.priority;
+    return top.id;
+}
+
+void radix_pq_decrease(radix_pq_t* q, int id, uint32_t priority)
+{
+    int b = q->where[id];
+    bucket_remove(q, b, q->pos[id]);
+    pq_entry_t e = {priority, id};
+    bucket_push(q, bucket_of(priority, q->last), e);
+}
@@ -1,107 +1,87 @@
 #include "sort.h"
 
-#define MAX_DIGIT 5
-#define RADIX 10
+#include <stdint.h>
+#include <string.h>
 
-struct node
-{
-    item_t key;
-    struct node* next;
-};
-typedef struct node* node_t;
+// Digit width in bits: 11 sorts 32-bit keys in 3 passes, 8 in 4 passes with smaller histograms.
+#define RADIX_BITS 11
+#define RADIX (1 << RADIX_BITS)
+#define PASSES ((32 + RADIX_BITS - 1) / RADIX_BITS)
 
-struct head_node
-{
-    node_t head;
-    node_t tail;
-};
+// Below this size the histograms cost more than the sort itself.
+#define RADIX_CUTOFF 64
 
-typedef struct head_node bucket_t[RADIX];
+// Flip the sign bit so that negative numbers order before positive ones as unsigned keys.
+static inline uint32_t get_key(item_t item)
+{
+    return (uint32_t)item ^ 0x80000000u;
+}
 
-static inline int get_digit(item_t item, int D)
+static inline int get_digit(uint32_t key, int pass)
 {
-    int digit;
+    return (key >> (pass * RADIX_BITS)) & (RADIX - 1);
+}
 
-    for (int i = 1; i <= D; i++)
+void radix_sort_ws(item_t arr[], int n, sort_workspace_t* ws)
+{
+    if (n < RADIX_CUTOFF)
     {
-        digit = (int)item % RADIX;
-        item /= RADIX;
+        insertion_sort(arr, n);
+        return;
     }
-    return digit;
-}
 
-void radix_sort(item_t arr[], int n)
-{
+    // 一次扫描统计所有位的直方图
+    int count[PASSES][RADIX] = {{0}};
     for (int i = 0; i < n; i++)
     {
-        if (arr[i] < 0)
+        uint32_t key = get_key(arr[i]);
+        for (int pass = 0; pass < PASSES; pass++)
         {
-            fprintf(stderr, "Radix sort can't handle negative numbers yet.\n");
-            return;
+            count[pass][get_digit(key, pass)]++;
         }
     }
 
-    int D, digit;
-    bucket_t bucket;
-    node_t tmp, p, list = NULL;
-
-    for (int i = 0; i < RADIX; i++)
-    {
-        bucket[i].head = NULL;
-        bucket[i].tail = NULL;
-    }
-    for (int i = 0; i < n; i++)
-    {
-        tmp = (node_t)malloc(sizeof(struct node));
-        check_pointer(tmp);
-
-        tmp->key = arr[i];
-        tmp->next = list;
-        list = tmp;
-    }
+    item_t* space = (item_t*)sort_workspace_reserve(ws, n * sizeof(item_t));
 
-    for (D = 1; D <= MAX_DIGIT; D++)
+    item_t* src = arr;
+    item_t* dst = space;
+    for (int pass = 0; pass < PASSES; pass++)
     {
-        p = list;
-        while (p)
+        // 所有元素的该位都相同时跳过这一趟
+        if (count[pass][get_digit(get_key(src[0]), pass)] == n)
         {
-            digit = get_digit(p->key, D);
-
-            tmp = p;
-            p = p->next;
-            tmp->next = NULL;
-
-            if (bucket[digit].head == NULL)
-            {
-                bucket[digit].head = tmp;
-                bucket[digit].tail = tmp;
-            }
-            else
-            {
-                bucket[digit].tail->next = tmp;
-                bucket[digit].tail = tmp;
-            }
+            continue;
         }
 
-        list = NULL;
+        // 前缀和得到每个桶的起始位置
+        int sum = 0;
+        for (int digit = 0; digit < RADIX; digit++)
+        {
+            int c = count[pass][digit];
+            count[pass][digit] = sum;
+            sum += c;
+        }
 
-        for (digit = RADIX - 1; digit >= 0; digit--)
+        for (int i = 0; i < n; i++)
         {
-            if (bucket[digit].head)
-            {
-                bucket[digit].tail->next = list;
-                list = bucket[digit].head;
-                bucket[digit].head = NULL;
-                bucket[digit].tail = NULL;
-            }
+            dst[count[pass][get_digit(get_key(src[i]), pass)]++] = src[i];
         }
+
+        item_t* tmp = src;
+        src = dst;
+        dst = tmp;
     }
 
-    for (int i = 0; i < n; i++)
+    if (src != arr)
     {
-        tmp = list;
-        list = list->next;
-        arr[i] = tmp->key;
-        free(tmp);
+        memcpy(arr, src, n * sizeof(item_t));
     }
 }
+
+void radix_sort(item_t arr[], int n)
+{
+    sort_workspace_t ws;
+    sort_workspace_init(&ws, 0);
+    radix_sort_ws(arr, n, &ws);
+    sort_workspace_free(&ws);
+}
@@ -0,0 +1,371 @@
+#include "sort.h"
+#include "thread_pool.h"
+
+#include <pthread.h>
+
+// In-place MSD radix sorts on the 8-bit digits of the key, no scratch copy of the input.
+//
+// radix_sort_inplace() is an American flag sort: count the digits, then permute the items into their
+// buckets by following cycles, and recurse into every bucket on the next digit.
+//
+// parallel_radix_sort_inplace() is a regions sort: every thread partitions its own block in place,
+// which leaves the array as a list of regions, runs of items with the same digit. A region lying
+// in another bucket's range has to move there; the moves are planned on regions only, one bucket at
+// a time: its foreign items are swapped with the items of that digit lying elsewhere, and the items
+// pushed out become new regions to place later. Every bucket needs one round of swaps on disjoint
+// ranges, which all the threads share. The buckets are then sorted in parallel on the next digit.
+
+// Buckets smaller than this are sorted by quick_sort.
+#define RADIX_INPLACE_THRESHOLD 128
+
+// Inputs smaller than this are sorted serially.
+#define REGIONS_SORT_THRESHOLD 65536
+
+static inline uint32_t get_key(item_t item)
+{
+    return (uint32_t)item ^ 0x80000000u; // 负数排在正数前面
+}
+
+static inline int get_digit(item_t item, int shift)
+{
+    return (get_key(item) >> shift) & 0xFF;
+}
+
+static void american_flag_sort(item_t arr[], int n, int shift)
+{
+    int count[256];
+    while (true)
+    {
+        if (n < RADIX_INPLACE_THRESHOLD)
+        {
+            quick_sort(arr, n);
+            return;
+        }
+
+        memset(count, 0, sizeof(count));
+        for (int i = 0; i < n; i++)
+        {
+            count[get_digit(arr[i], shift)]++;
+        }
+        // 所有元素的该位都相同时直接看下一位
+        if (count[get_digit(arr[0], shift)] < n)
+        {
+            break;
+        }
+        if (shift == 0)
+        {
+            return;
+        }
+        shift -= 8;
+    }
+
+    int head[256], tail[256];
+    int sum = 0;
+    for (int d = 0; d < 256; d++)
+    {
+        head[d] = sum;
+        sum += count[d];
+        tail[d] = sum;
+    }
+
+    // 沿置换环把每个元素换到它的桶里，每个元素只写一次
+    for (int d = 0; d < 256; d++)
+    {
+        while (head[d] < tail[d])
+        {
+            item_t x = arr[head[d]];
+            int digit = get_digit(x, shift);
+            while (digit != d)
+            {
+                item_t tmp = arr[head[digit]];
+                arr[head[digit]++] = x;
+                x = tmp;
+                digit = get_digit(x, shift);
+            }
+            arr[head[d]++] = x;
+        }
+    }
+
+    if (shift > 0)
+    {
+        for (int d = 0, begin = 0; d < 256; begin += count[d++])
+        {
+            if (count[d] > 1)
+            {
+                american_flag_sort(arr + begin, count[d], shift - 8);
+            }
+        }
+    }
+}
+
+void radix_sort_inplace(item_t arr[], int n)
+{
+    american_flag_sort(arr, n, 24);
+}
+
+typedef struct
+{
+    int pos;
+    int len;
+    int tag; // bucket the region lies in, or its digit, depending on the list
+} region_t;
+
+typedef struct
+{
+    region_t* regions;
+    int size;
+    int capacity;
+} region_list_t;
+
+static void region_push(region_list_t* list, int pos, int len, int tag)
+{
+    if (list->size == list->capacity)
+    {
+        list->capacity = list->capacity ? 2 * list->capacity : 16;
+        list->regions = (region_t*)realloc(list->regions, list->capacity * sizeof(region_t));
+        check_pointer(list->regions);
+    }
+    list->regions[list->size++] = (region_t){pos, len, tag};
+}
+
+struct regions_sort
+{
+    item_t* arr;
+    int n;
+    int shift;
+    int threads;
+    int blocks;
+    int* counts;         // counts[block * 256 + digit]
+    int start[257];      // bucket ranges in the sorted array
+    region_list_t swaps; // swaps[round_start[r], round_start[r + 1]) in round r, `tag` is the other position
+    int round_start[257];
+    int rounds;
+    pthread_barrier_t barrier;
+};
+
+static inline int block_begin(const struct regions_sort* rs, int block)
+{
+    return (int)((long)rs->n * block / rs->blocks);
+}
+
+// One level of American flag sort on a block, keeping its digit counts.
+static void partition_block(void* context, int block)
+{
+    struct regions_sort* rs = (struct regions_sort*)context;
+    item_t* arr = rs->arr + block_begin(rs, block);
+    int n = block_begin(rs, block + 1) - block_begin(rs, block);
+    int* count = rs->counts + block * 256;
+    for (int i = 0; i < n; i++)
+    {
+        count[get_digit(arr[i], rs->shift)]++;
+    }
+
+    int head[256], tail[256];
+    int sum = 0;
+    for (int d = 0; d < 256; d++)
+    {
+        head[d] = sum;
+        sum += count[d];
+        tail[d] = sum;
+    }
+    for (int d = 0; d < 256; d++)
+    {
+        while (head[d] < tail[d])
+        {
+            item_t x = arr[head[d]];
+            int digit = get_digit(x, rs->shift);
+            while (digit != d)
+            {
+                item_t tmp = arr[head[digit]];
+                arr[head[digit]++] = x;
+                x = tmp;
+                digit = get_digit(x, rs->shift);
+            }
+            arr[head[d]++] = x;
+        }
+    }
+}
+
+// Plan the swaps that bring every item into its bucket, bucket by bucket, on regions only.
+static void plan_swaps(struct regions_sort* rs)
+{
+    // incoming[d]: 其他桶中数位为 d 的区域（tag 为所在的桶）
+    // foreign[b]: 桶 b 中不属于它的区域（tag 为数位）
+    // 区域中的元素只在处理它的数位或所在的桶时移走，所以 tag 已处理过的区域都已过期
+    region_list_t incoming[256] = {{0}}, foreign[256] = {{0}};
+    bool placed[256] = {false};
+
+    for (int block = 0; block < rs->blocks; block++)
+    {
+        int pos = block_begin(rs, block);
+        for (int d = 0; d < 256; d++)
+        {
+            int end = pos + rs->counts[block * 256 + d];
+            for (int b = 0; pos < end; b++)
+            {
+                if (rs->start[b + 1] <= pos)
+                {
+                    continue;
+                }
+                int stop = end < rs->start[b + 1] ? end : rs->start[b + 1];
+                if (b != d)
+                {
+                    region_push(&incoming[d], pos, stop - pos, b);
+                    region_push(&foreign[b], pos, stop - pos, d);
+                }
+                pos = stop;
+            }
+        }
+    }
+
+    rs->rounds = 0;
+    for (int b = 0; b < 256; b++)
+    {
+        rs->round_start[rs->rounds] = rs->swaps.size;
+        int o = 0, in_used = 0, out_used = 0;
+        for (int i = 0; i < incoming[b].size; i++)
+        {
+            region_t in = incoming[b].regions[i];
+            if (placed[in.tag])
+            {
+                continue;
+            }
+            while (in_used < in.len)
+            {
+                region_t out = foreign[b].regions[o];
+                if (placed[out.tag] || out_used == out.len)
+                {
+                    o++;
+                    out_used = 0;
+                    continue;
+                }
+
+                // 交换后桶 b 的元素就位，换出的元素成为所在桶 in.tag 中的新区域
+                int len = in.len - in_used < out.len - out_used ? in.len - in_used : out.len - out_used;
+                int p = in.pos + in_used, q = out.pos + out_used;
+                region_push(&rs->swaps, p, len, q);
+                if (in.tag != out.tag)
+                {
+                    region_push(&incoming[out.tag], p, len, in.tag);
+                    region_push(&foreign[in.tag], p, len, out.tag);
+                }
+                in_used += len;
+                out_used += len;
+            }
+            in_used = 0;
+        }
+        placed[b] = true;
+        if (rs->swaps.size > rs->round_start[rs->rounds])
+        {
+            rs->rounds++;
+        }
+    }
+    rs->round_start[rs->rounds] = rs->swaps.size;
+
+    for (int d = 0; d < 256; d++)
+    {
+        free(incoming[d].regions);
+        free(foreign[d].regions);
+    }
+}
+
+// Thread `part` does its share of the items of every round, rounds are separated by a barrier.
+static void execute_swaps(void* context, int part)
+{
+    struct regions_sort* rs = (struct regions_sort*)context;
+    for (int r = 0; r < rs->rounds; r++)
+    {
+        long total = 0;
+        for (int s = rs->round_start[r]; s < rs->round_start[r + 1]; s++)
+        {
+            total += rs->swaps.regions[s].len;
+        }
+        long begin = total * part / rs->threads, end = total * (part + 1) / rs->threads;
+
+        long offset = 0;
+        for (int s = rs->round_start[r]; s < rs->round_start[r + 1] && offset < end; s++)
+        {
+            region_t swap_op = rs->swaps.regions[s];
+            long from = begin > offset ? begin - offset : 0;
+            long to = end - offset < swap_op.len ? end - offset : swap_op.len;
+            item_t* a = rs->arr + swap_op.pos;
+            item_t* b = rs->arr + swap_op.tag;
+            for (long i = from; i < to; i++)
+            {
+                swap(&a[i], &b[i]);
+            }
+            offset += swap_op.len;
+        }
+        pthread_barrier_wait(&rs->barrier);
+    }
+}
+
+static void sort_bucket(void* context, int d)
+{
+    struct regions_sort* rs = (struct regions_sort*)context;
+    int size = rs->start[d + 1] - rs->start[d];
+    if (size <= rs->n / rs->threads && size > 1)
+    {
+        american_flag_sort(rs->arr + rs->start[d], size, rs->shift - 8);
+    }
+}
+
+static void regions_sort(item_t arr[], int n, int shift, int threads)
+{
+    if (n <= REGIONS_SORT_THRESHOLD)
+    {
+        american_flag_sort(arr, n, shift);
+        return;
+    }
+
+    struct regions_sort rs = {arr, n, shift, threads, threads};
+    rs.counts = (int*)sort_malloc(rs.blocks * 256 * sizeof(int));
+    memset(rs.counts, 0, rs.blocks * 256 * sizeof(int));
+    pool_for(threads, rs.blocks, partition_block, &rs);
+
+    rs.start[0] = 0;
+    for (int d = 0; d < 256; d++)
+    {
+        rs.start[d + 1] = rs.start[d];
+        for (int block = 0; block < rs.blocks; block++)
+        {
+            rs.start[d + 1] += rs.counts[block * 256 + d];
+        }
+    }
+
+    plan_swaps(&rs);
+    // 每个线程恰好执行一个任务，所以屏障不会死锁
+    pthread_barrier_init(&rs.barrier, NULL, threads);
+    pool_for(threads, threads, execute_swaps, &rs);
+    pthread_barrier_destroy(&rs.barrier);
+    free(rs.swaps.regions);
+    free(rs.counts);
+
+    if (shift > 0)
+    {
+        // 小桶并行地各自串行排序，大桶继续并行划分
+        pool_for(threads, 256, sort_bucket, &rs);
+        for (int d = 0; d < 256; d++)
+        {
+            int size = rs.start[d + 1] - rs.start[d];
+            if (size > n / threads)
+            {
+                regions_sort(arr + rs.start[d], size, shift - 8, threads);
+            }
+        }
+    }
+}
+
+void parallel_radix_sort_inplace(item_t arr[], int n, int threads)
+{
+    if (threads <= 0)
+    {
+        threads = cpu_count();
+    }
+    if (threads == 1)
+    {
+        american_flag_sort(arr, n, 24);
+        return;
+    }
+    regions_sort(arr, n, 24, threads);
+}
@@ -0,0 +1,200 @@
+#include "dary_heap.h"
+#include "sort.h"
+
+// Selection: introselect with a median-of-medians fallback, partial sort built on it, and a streaming
+// top-k accumulator that keeps the k smallest items of all the chunks pushed so far.
+
+// Ranges smaller than this are finished by insertion sort.
+#define SELECT_THRESHOLD 16
+
+// Ranges larger than this choose the pivot with Tukey's ninther instead of median-of-three.
+#define SELECT_NINTHER_THRESHOLD 128
+
+// Arity of the top-k heap.
+#define TOPK_ARITY 4
+
+static inline item_t median3(item_t a, item_t b, item_t c)
+{
+    if (b < a)
+    {
+        item_t tmp = a;
+        a = b;
+        b = tmp;
+    }
+    return c < a ? a : c < b ? c : b;
+}
+
+static item_t median_of_medians(item_t arr[], int n);
+
+// Rearrange arr[0, n) so that arr[k] is the item a full sort would put there, with no larger item
+// before it and no smaller one after it. `budget` bad partitions are allowed before the pivots
+// come from the median of medians, which bounds the work to O(n).
+static void select_range(item_t arr[], int n, int k, int budget)
+{
+    while (n > SELECT_THRESHOLD)
+    {
+        item_t pivot;
+        if (budget > 0)
+        {
+            int mid = n / 2;
+            if (n > SELECT_NINTHER_THRESHOLD)
+            {
+                int s = n / 8;
+                pivot = median3(median3(arr[0], arr[s], arr[2 * s]), median3(arr[mid - s], arr[mid], arr[mid + s]),
+                                median3(arr[n - 1 - 2 * s], arr[n - 1 - s], arr[n - 1]));
+            }
+            else
+            {
+                pivot = median3(arr[0], arr[mid], arr[n - 1]);
+            }
+        }
+        else
+        {
+            pivot = median_of_medians(arr, n);
+        }
+
+        // 三路划分：[0, lt) < pivot, [lt, gt) == pivot, [gt, n) > pivot
+        int lt = 0, i = 0, gt = n;
+        while (i < gt)
+        {
+            if (arr[i] < pivot)
+            {
+                swap(&arr[lt++], &arr[i++]);
+            }
+            else if (pivot < arr[i])
+            {
+                swap(&arr[i], &arr[--gt]);
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        int size = n;
+        if (k < lt)
+        {
+            n = lt;
+        }
+        else if (k >= gt)
+        {
+            arr += gt;
+            n -= gt;
+            k -= gt;
+        }
+        else
+        {
+            return;
+        }
+        // 剩余范围超过原来的 3/4 视为一次糟糕的划分
+        if (n > size / 4 * 3)
+        {
+            budget--;
+        }
+    }
+    insertion_sort(arr, n);
+}
+
+// Median of the medians of groups of five, moved to the front and selected recursively.
+static item_t median_of_medians(item_t arr[], int n)
+{
+    int groups = 0;
+    for (int i = 0; i + 5 <= n; i += 5)
+    {
+        insertion_sort(arr + i, 5);
+        swap(&arr[groups++], &arr[i + 2]);
+    }
+    if (groups == 0)
+    {
+        insertion_sort(arr, n);
+        return arr[n / 2];
+    }
+    select_range(arr, groups, groups / 2, 0);
+    return arr[groups / 2];
+}
+
+void select_nth(item_t arr[], int n, int k)
+{
+    if (k < 0 || k >= n)
+    {
+        return;
+    }
+    int budget = 0;
+    for (int i = n; i > 1; i >>= 1)
+    {
+        budget++;
+    }
+    select_range(arr, n, k, budget);
+}
+
+void partial_sort(item_t arr[], int n, int k)
+{
+    if (k <= 0)
+    {
+        return;
+    }
+    if (k < n)
+    {
+        select_nth(arr, n, k - 1);
+        n = k - 1; // arr[k - 1] 已就位
+    }
+    quick_sort(arr, n);
+}
+
+void topk_init(topk_t* topk, int k)
+{
+    topk->k = k > 0 ? k : 0;
+    topk->size = 0;
+    topk->heap = (item_t*)sort_malloc((topk->k > 0 ? topk->k : 1) * sizeof(item_t));
+}
+
+void topk_push(topk_t* topk, const item_t chunk[], int n)
+{
+    item_t* heap = topk->heap;
+    int k = topk->k;
+    int i = 0;
+
+    // 堆未满时直接追加，满的那一刻建堆
+    if (topk->size < k)
+    {
+        int take = n < k - topk->size ? n : k - topk->size;
+        memcpy(heap + topk->size, chunk, take * sizeof(item_t));
+        topk->size += take;
+        i = take;
+        if (topk->size == k)
+        {
+            for (int r = (k - 2) / TOPK_ARITY; r >= 0; r--)
+            {
+                dary_sift_down(heap, r, k, heap[r], TOPK_ARITY);
+            }
+        }
+    }
+    if (topk->size < k || k == 0)
+    {
+        return;
+    }
+
+    // 堆顶是当前第 k 小的元素，不小于它的直接丢弃，只有更小的才进堆
+    item_t threshold = heap[0];
+    for (; i < n; i++)
+    {
+        if (chunk[i] < threshold)
+        {
+            dary_sift_down(heap, 0, k, chunk[i], TOPK_ARITY);
+            threshold = heap[0];
+        }
+    }
+}
+
+int topk_result(const topk_t* topk, item_t out[])
+{
+    memcpy(out, topk->heap, topk->size * sizeof(item_t));
+    quick_sort(out, topk->size);
+    return topk->size;
+}
+
+void topk_free(topk_t* topk)
+{
+    free(topk->heap);
+    topk->heap = NULL;
+}
@@ -1,38 +1,25 @@
 #include "sort.h"
 
-#include <math.h> // pow
+// Sedgewick's gaps 9 * (4^i - 2^i) + 1 and 4^i - 3 * 2^i + 1 merged in increasing order, up to INT_MAX.
+static const int sedgewick[] = {
+    1,       5,        19,       41,       109,       209,       505,       929,       2161,       3905,
+    8929,    16001,    36289,    64769,    146305,    260609,    587521,    1045505,   2354689,    4188161,
+    9427969, 16764929, 37730305, 67084289, 150958081, 268386305, 603906049, 1073643521,
+};
 
-#define Sedgewick_SIZE 10
-
-static inline int* Sedgewick(int n)
-{
-    int* sedgewick = (int*)malloc(sizeof(int) * n);
-    check_pointer(sedgewick);
-
-    for (int i = 0; i < n; i += 2)
-    {
-        sedgewick[i] = 9 * pow(4, i) - 9 * pow(2, i) + 1;
-        if (i + 1 < n)
-        {
-            sedgewick[i + 1] = pow(4, i + 2) - 3 * pow(2, i + 2) + 1;
-        }
-    }
-
-    return sedgewick; // {s[0]=1, s[1]=5, s[2]=19, s[3]=41, ..., s[n-1]}
-}
+#define SEDGEWICK_SIZE ((int)(sizeof(sedgewick) / sizeof(sedgewick[0])))
 
 void shell_sort(item_t arr[], int n)
 {
-    int* sedgewick = Sedgewick(Sedgewick_SIZE);
-
     int i, j, si;
     item_t tmp;
 
-    for (si = Sedgewick_SIZE - 1; sedgewick[si] >= n; si--)
+    for (si = SEDGEWICK_SIZE - 1; si > 0 && sedgewick[si] >= n; si--)
         ;
 
-    for (int step = sedgewick[si]; si != -1; step = sedgewick[--si])
+    for (; si >= 0; si--)
     {
+        int step = sedgewick[si];
         for (i = step; i < n; i++)
         {
             tmp = arr[i];
@@ -43,6 +30,4 @@ void shell_sort(item_t arr[], int n)
             arr[j] = tmp;
         }
     }
-
-    free(sedgewick);
 }
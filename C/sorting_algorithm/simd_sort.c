@@ -0,0 +1,375 @@
+#include "sort.h"
+
+#include <limits.h>
+#include <string.h>
+
+// Bitonic sorting networks on 8 x 32-bit lanes, AVX2 when compiled with -mavx2 (or -march=native),
+// two SSE4.1 registers per vector with -msse4.1, and plain insertion sort otherwise.
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#define SIMD_SORT_ENABLED
+
+typedef __m256i vec_t;
+
+static inline vec_t vec_load(const item_t* p)
+{
+    return _mm256_loadu_si256((const __m256i*)p);
+}
+
+static inline void vec_store(item_t* p, vec_t v)
+{
+    _mm256_storeu_si256((__m256i*)p, v);
+}
+
+static inline vec_t vec_min(vec_t a, vec_t b)
+{
+    return _mm256_min_epi32(a, b);
+}
+
+static inline vec_t vec_max(vec_t a, vec_t b)
+{
+    return _mm256_max_epi32(a, b);
+}
+
+static inline vec_t vec_reverse(vec_t v)
+{
+    return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+// Compare lane i with lane i ^ 1 (or i ^ 2), the lanes set in MASK keep the maximum.
+#define STAGE1(v, MASK)                                                      \
+    do                                                                       \
+    {                                                                        \
+        vec_t p_ = _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));         \
+        v = _mm256_blend_epi32(vec_min(v, p_), vec_max(v, p_), MASK);        \
+    } while (0)
+
+#define STAGE2(v, MASK)                                                      \
+    do                                                                       \
+    {                                                                        \
+        vec_t p_ = _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));         \
+        v = _mm256_blend_epi32(vec_min(v, p_), vec_max(v, p_), MASK);        \
+    } while (0)
+
+// Compare lane i with lane i ^ 4, the upper half keeps the maximum.
+#define STAGE4(v)                                                            \
+    do                                                                       \
+    {                                                                        \
+        vec_t p_ = _mm256_permute2x128_si256(v, v, 1);                       \
+        v = _mm256_blend_epi32(vec_min(v, p_), vec_max(v, p_), 0xF0);        \
+    } while (0)
+
+#elif defined(__SSE4_1__)
+
+#include <smmintrin.h>
+
+#define SIMD_SORT_ENABLED
+
+typedef struct
+{
+    __m128i lo; // lanes 0..3
+    __m128i hi; // lanes 4..7
+} vec_t;
+
+static inline vec_t vec_load(const item_t* p)
+{
+    vec_t v = {_mm_loadu_si128((const __m128i*)p), _mm_loadu_si128((const __m128i*)(p + 4))};
+    return v;
+}
+
+static inline void vec_store(item_t* p, vec_t v)
+{
+    _mm_storeu_si128((__m128i*)p, v.lo);
+    _mm_storeu_si128((__m128i*)(p + 4), v.hi);
+}
+
+static inline vec_t vec_min(vec_t a, vec_t b)
+{
+    vec_t v = {_mm_min_epi32(a.lo, b.lo), _mm_min_epi32(a.hi, b.hi)};
+    return v;
+}
+
+static inline vec_t vec_max(vec_t a, vec_t b)
+{
+    vec_t v = {_mm_max_epi32(a.lo, b.lo), _mm_max_epi32(a.hi, b.hi)};
+    return v;
+}
+
+static inline vec_t vec_reverse(vec_t v)
+{
+    vec_t r = {_mm_shuffle_epi32(v.hi, _MM_SHUFFLE(0, 1, 2, 3)), _mm_shuffle_epi32(v.lo, _MM_SHUFFLE(0, 1, 2, 3))};
+    return r;
+}
+
+// _mm_blend_epi16 works on 16-bit lanes, so every bit of the 32-bit lane mask is doubled.
+#define BLEND_MASK(m) ((((m) & 1) ? 0x03 : 0) | (((m) & 2) ? 0x0C : 0) | (((m) & 4) ? 0x30 : 0) | (((m) & 8) ? 0xC0 : 0))
+
+#define HALF_STAGE(x, SHUF, MASK)                                                                  \
+    do                                                                                             \
+    {                                                                                              \
+        __m128i p_ = _mm_shuffle_epi32(x, SHUF);                                                   \
+        x = _mm_blend_epi16(_mm_min_epi32(x, p_), _mm_max_epi32(x, p_), BLEND_MASK(MASK));         \
+    } while (0)
+
+#define STAGE1(v, MASK)                                                      \
+    do                                                                       \
+    {                                                                        \
+        HALF_STAGE((v).lo, _MM_SHUFFLE(2, 3, 0, 1), (MASK) & 0xF);           \
+        HALF_STAGE((v).hi, _MM_SHUFFLE(2, 3, 0, 1), (MASK) >> 4);            \
+    } while (0)
+
+#define STAGE2(v, MASK)                                                      \
+    do                                                                       \
+    {                                                                        \
+        HALF_STAGE((v).lo, _MM_SHUFFLE(1, 0, 3, 2), (MASK) & 0xF);           \
+        HALF_STAGE((v).hi, _MM_SHUFFLE(1, 0, 3, 2), (MASK) >> 4);            \
+    } while (0)
+
+#define STAGE4(v)                                                            \
+    do                                                                       \
+    {                                                                        \
+        __m128i lo_ = _mm_min_epi32((v).lo, (v).hi);                         \
+        (v).hi = _mm_max_epi32((v).lo, (v).hi);                              \
+        (v).lo = lo_;                                                        \
+    } while (0)
+
+#endif
+
+#ifdef SIMD_SORT_ENABLED
+
+// Sort the 8 lanes of a bitonic vector in ascending order.
+static inline vec_t merge8(vec_t v)
+{
+    STAGE4(v);
+    STAGE2(v, 0xCC);
+    STAGE1(v, 0xAA);
+    return v;
+}
+
+// Sort the 8 lanes of a vector: bitonic sort, stage (k, j) pairs lane i with i ^ j.
+static inline vec_t sort8(vec_t v)
+{
+    STAGE1(v, 0x66); // k = 2
+    STAGE2(v, 0x3C); // k = 4
+    STAGE1(v, 0x5A);
+    return merge8(v); // k = 8
+}
+
+// Merge two sorted vectors in registers: a gets the 8 smallest, b the 8 largest, both sorted.
+static inline void merge_2x8(vec_t* a, vec_t* b)
+{
+    vec_t r = vec_reverse(*b);
+    vec_t lo = vec_min(*a, r);
+    vec_t hi = vec_max(*a, r);
+    *a = merge8(lo);
+    *b = merge8(hi);
+}
+
+// Sort a bitonic sequence held in k vectors.
+static inline void bitonic_clean(vec_t v[], int k)
+{
+    if (k == 1)
+    {
+        v[0] = merge8(v[0]);
+        return;
+    }
+    int half = k / 2;
+    for (int i = 0; i < half; i++)
+    {
+        vec_t lo = vec_min(v[i], v[half + i]);
+        v[half + i] = vec_max(v[i], v[half + i]);
+        v[i] = lo;
+    }
+    bitonic_clean(v, half);
+    bitonic_clean(v + half, half);
+}
+
+// Merge v[0, k/2) and v[k/2, k), each sorted, into one sorted sequence of k vectors.
+static inline void bitonic_merge(vec_t v[], int k)
+{
+    int half = k / 2;
+    for (int i = 0; i < half; i++)
+    {
+        vec_t r = vec_reverse(v[k - 1 - i]);
+        vec_t lo = vec_min(v[i], r);
+        vec_t hi = vec_max(v[i], r);
+        v[i] = lo;
+        v[k - 1 - i] = hi;
+    }
+    // 第二半此时是逆序存放的双调序列，先按位置还原再清理
+    for (int i = half, j = k - 1; i < j; i++, j--)
+    {
+        vec_t tmp = v[i];
+        v[i] = v[j];
+        v[j] = tmp;
+    }
+    bitonic_clean(v, half);
+    bitonic_clean(v + half, half);
+}
+
+// Sort 8 * k items (k = 1, 2, 4 or 8) held in k vectors.
+static inline void sort_vectors(vec_t v[], int k)
+{
+    for (int i = 0; i < k; i++)
+    {
+        v[i] = sort8(v[i]);
+    }
+    for (int width = 2; width <= k; width *= 2)
+    {
+        for (int i = 0; i < k; i += width)
+        {
+            bitonic_merge(v + i, width);
+        }
+    }
+}
+
+#endif // SIMD_SORT_ENABLED
+
+void simd_small_sort(item_t arr[], int n)
+{
+#ifdef SIMD_SORT_ENABLED
+    if (n < 2)
+    {
+        return;
+    }
+
+    // 不足 8 的倍数时用最大值填充
+    item_t buf[SIMD_SORT_MAX];
+    vec_t v[SIMD_SORT_MAX / 8];
+    int k = n <= 8 ? 1 : n <= 16 ? 2 : n <= 32 ? 4 : 8;
+    memcpy(buf, arr, n * sizeof(item_t));
+    for (int i = n; i < 8 * k; i++)
+    {
+        buf[i] = INT_MAX;
+    }
+
+    for (int i = 0; i < k; i++)
+    {
+        v[i] = vec_load(buf + 8 * i);
+    }
+    sort_vectors(v, k);
+    for (int i = 0; i < k; i++)
+    {
+        vec_store(buf + 8 * i, v[i]);
+    }
+    memcpy(arr, buf, n * sizeof(item_t));
+#else
+    insertion_sort(arr, n);
+#endif
+}
+
+// Merge sorted a[0, la) and b[0, lb) into out.
+static void merge_runs(const item_t* a, int la, const item_t* b, int lb, item_t* out)
+{
+#ifdef SIMD_SORT_ENABLED
+    if (la >= 8 && lb >= 8)
+    {
+        // 每次从首元素较小的一段载入 8 个元素，与寄存器中剩余的 8 个合并并输出较小的一半
+        vec_t lo = vec_load(a), hi = vec_load(b);
+        a += 8, la -= 8;
+        b += 8, lb -= 8;
+        merge_2x8(&lo, &hi);
+        vec_store(out, lo);
+        out += 8;
+        while (la >= 8 && lb >= 8)
+        {
+            if (*a < *b)
+            {
+                lo = vec_load(a);
+                a += 8, la -= 8;
+            }
+            else
+            {
+                lo = vec_load(b);
+                b += 8, lb -= 8;
+            }
+            merge_2x8(&lo, &hi);
+            vec_store(out, lo);
+            out += 8;
+        }
+
+        // 寄存器中剩余的 8 个元素与两段的尾部做三路合并
+        item_t carry[8];
+        vec_store(carry, hi);
+        int lc = 8;
+        const item_t* c = carry;
+        while (lc > 0)
+        {
+            if (la > 0 && *a < *c && (lb == 0 || *a <= *b))
+            {
+                *out++ = *a++, la--;
+            }
+            else if (lb > 0 && *b < *c)
+            {
+                *out++ = *b++, lb--;
+            }
+            else
+            {
+                *out++ = *c++, lc--;
+            }
+        }
+    }
+#endif
+    while (la > 0 && lb > 0)
+    {
+        if (*b < *a)
+        {
+            *out++ = *b++, lb--;
+        }
+        else
+        {
+            *out++ = *a++, la--;
+        }
+    }
+    memcpy(out, a, la * sizeof(item_t));
+    memcpy(out + la, b, lb * sizeof(item_t));
+}
+
+void simd_sort_ws(item_t arr[], int n, sort_workspace_t* ws)
+{
+    if (n <= SIMD_SORT_MAX)
+    {
+        simd_small_sort(arr, n);
+        return;
+    }
+
+    // 先用排序网络排好每个 64 元素的块
+    for (int i = 0; i < n; i += SIMD_SORT_MAX)
+    {
+        simd_small_sort(arr + i, n - i < SIMD_SORT_MAX ? n - i : SIMD_SORT_MAX);
+    }
+
+    // 再自底向上两两归并
+    item_t* space = (item_t*)sort_workspace_reserve(ws, n * sizeof(item_t));
+
+    item_t* src = arr;
+    item_t* dst = space;
+    for (int width = SIMD_SORT_MAX; width < n; width *= 2)
+    {
+        for (int lo = 0; lo < n; lo += 2 * width)
+        {
+            int mid = lo + width < n ? lo + width : n;
+            int hi = lo + 2 * width < n ? lo + 2 * width : n;
+            merge_runs(src + lo, mid - lo, src + mid, hi - mid, dst + lo);
+        }
+        item_t* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != arr)
+    {
+        memcpy(arr, src, n * sizeof(item_t));
+    }
+}
+
+void simd_sort(item_t arr[], int n)
+{
+    sort_workspace_t ws;
+    sort_workspace_init(&ws, 0);
+    simd_sort_ws(arr, n, &ws);
+    sort_workspace_free(&ws);
+}
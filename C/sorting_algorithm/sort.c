@@ -0,0 +1,43 @@
+#include "sort.h"
+
+#include <stdatomic.h>
+
+// State shared by all the sorts.
+
+static atomic_long alloc_count = 0;
+
+long sort_alloc_count(void)
+{
+    return atomic_load_explicit(&alloc_count, memory_order_relaxed);
+}
+
+void sort_count_alloc(void)
+{
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+}
+
+void sort_workspace_init(sort_workspace_t* ws, size_t size)
+{
+    ws->memory = size > 0 ? sort_malloc(size) : NULL;
+    ws->size = size;
+}
+
+void sort_workspace_free(sort_workspace_t* ws)
+{
+    free(ws->memory);
+    ws->memory = NULL;
+    ws->size = 0;
+}
+
+void* sort_workspace_reserve(sort_workspace_t* ws, size_t size)
+{
+    if (size > ws->size)
+    {
+        // 按 1.5 倍增长，尺寸缓慢变化的一串排序只需分配几次
+        size_t grow = ws->size + ws->size / 2;
+        free(ws->memory);
+        ws->size = size > grow ? size : grow;
+        ws->memory = sort_malloc(ws->size);
+    }
+    return ws->memory;
+}
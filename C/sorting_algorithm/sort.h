@@ -2,11 +2,24 @@
 #define SORT_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 typedef int item_t;
 
+// A 64-bit key with the row it came from, sorted by key only.
+typedef struct
+{
+    uint64_t key;
+    uint32_t row;
+} record_t;
+
 // Check whether the pointer is a non-null pointer.
 static inline void check_pointer(const void* pointer)
 {
@@ -17,6 +30,49 @@ static inline void check_pointer(const void* pointer)
     }
 }
 
+// Number of allocations made through sort_malloc(), the benchmark reports it per sort. The counter
+// lives in sort.c, so the header stays includable from C++ without <stdatomic.h>.
+long sort_alloc_count(void);
+
+// Count one allocation, safe from any thread.
+void sort_count_alloc(void);
+
+// Allocate memory for a sort, exit on failure.
+static inline void* sort_malloc(size_t size)
+{
+    void* pointer = malloc(size);
+    check_pointer(pointer);
+    sort_count_alloc();
+    return pointer;
+}
+
+// Same for memory aligned to `alignment`, a power of 2, with `size` rounded up to a multiple of it.
+static inline void* sort_aligned_malloc(size_t alignment, size_t size)
+{
+    void* pointer = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    check_pointer(pointer);
+    sort_count_alloc();
+    return pointer;
+}
+
+// Scratch memory created once and passed to the `_ws` sorts, which take their buffers from it and
+// only allocate when it is too small. Every sort that needs scratch memory has a `_ws` variant,
+// except the parallel sorts, whose buffers are per thread. external_sort() and the structures with
+// their own lifetime (topk_t, btree_t, the priority queues) allocate on their own too.
+// A workspace must not be used by two sorts at the same time.
+typedef struct
+{
+    void* memory;
+    size_t size;
+} sort_workspace_t;
+
+// Start with `size` bytes, 0 allocates nothing until a sort needs it.
+void sort_workspace_init(sort_workspace_t* ws, size_t size);
+void sort_workspace_free(sort_workspace_t* ws);
+
+// At least `size` bytes, aligned for any item type, valid until the next call. Contents are not kept.
+void* sort_workspace_reserve(sort_workspace_t* ws, size_t size);
+
 // Swap the content of the two items.
 static inline void swap(item_t* a, item_t* b)
 {
@@ -25,13 +81,189 @@ static inline void swap(item_t* a, item_t* b)
     *b = tmp;
 }
 
+// First position in sorted arr[0, n) whose item is not less (or, if `upper`, greater) than x, without branches.
+static inline int search_bound(const item_t arr[], int n, item_t x, bool upper)
+{
+    if (n == 0)
+    {
+        return 0;
+    }
+    const item_t* base = arr;
+    while (n > 1)
+    {
+        int half = n / 2;
+        base = (upper ? base[half - 1] <= x : base[half - 1] < x) ? base + half : base;
+        n -= half;
+    }
+    return (int)(base - arr) + (upper ? *base <= x : *base < x);
+}
+
 void bubble_sort(item_t arr[], int n);
 void insertion_sort(item_t arr[], int n);
 void shell_sort(item_t arr[], int n);
 void selection_sort(item_t arr[], int n);
 void heap_sort(item_t arr[], int n);
+void heap4_sort(item_t arr[], int n); // 4-ary heap, see dary_heap_sort.c
+void heap8_sort(item_t arr[], int n); // 8-ary heap
 void merge_sort(item_t arr[], int n);
+void inplace_merge_sort(item_t arr[], int n); // stable, O(1) memory, see inplace_merge_sort.c
+void tim_sort(item_t arr[], int n);
 void quick_sort(item_t arr[], int n);
 void radix_sort(item_t arr[], int n);
+void radix_sort_inplace(item_t arr[], int n); // American flag sort, see radix_sort_inplace.c
+void simd_sort(item_t arr[], int n);
+
+// Largest input of the in-register sorting networks used as base case by the other sorts.
+#define SIMD_SORT_MAX 64
+void simd_small_sort(item_t arr[], int n);
+
+// Parallel sorts, `threads <= 0` means one thread per online processor.
+void parallel_quick_sort(item_t arr[], int n, int threads);
+void parallel_sample_sort(item_t arr[], int n, int threads);
+void parallel_merge_sort(item_t arr[], int n, int threads);
+void parallel_radix_sort_inplace(item_t arr[], int n, int threads); // regions sort
+
+// Selection, see select.c. select_nth() leaves arr[k] where a full sort would put it, with no larger
+// item before and no smaller item after it. partial_sort() sorts the k smallest items into arr[0, k).
+void select_nth(item_t arr[], int n, int k);
+void partial_sort(item_t arr[], int n, int k);
+
+// Streaming top-k: a bounded max-heap of the k smallest items of all the chunks pushed so far.
+typedef struct
+{
+    item_t* heap;
+    int k;
+    int size;
+} topk_t;
+
+void topk_init(topk_t* topk, int k);
+void topk_push(topk_t* topk, const item_t chunk[], int n);
+int topk_result(const topk_t* topk, item_t out[]); // write the items in ascending order, return how many
+void topk_free(topk_t* topk);
+
+// Multi-key sort of records through memcmp-comparable normalized keys, see key_sort.c.
+enum column_type
+{
+    COLUMN_INT32,
+    COLUMN_INT64,
+    COLUMN_DOUBLE,
+    COLUMN_STRING, // a `const char*` field
+};
+
+typedef struct
+{
+    enum column_type type;
+    size_t offset; // offsetof() the field in the record
+    bool descending;
+    int prefix; // bytes of a string kept in the key, 0 for the default
+} sort_column_t;
+
+int normalized_key_width(const sort_column_t columns[], int count);
+void normalize_key(const sort_column_t columns[], int count, const void* record, uint8_t out[]);
+
+// Write to order[] the indices of the n records of `size` bytes sorted by the columns, ties keep their order.
+void sort_by_columns(const void* records, int n, size_t size, const sort_column_t columns[], int count,
+                     uint32_t order[]);
+
+// Sort the binary file of item_t at `input` into `output` with about `memory` bytes of RAM,
+// sorted runs are spilled to temp files under `temp_dir`. Return false on I/O errors, or when the
+// input size is not a multiple of sizeof(item_t).
+bool external_sort(const char* input, const char* output, size_t memory, const char* temp_dir);
+
+// Stable merge sort with the caller's buffer of `size` items, any size works and sqrt(n) is enough
+// to come close to merge_sort().
+void inplace_merge_sort_buffer(item_t arr[], int n, item_t buffer[], int size);
+
+// Counting sorts, see counting_sort.c. A key range larger than 2n goes to radix_sort() or
+// parallel_sample_sort(), and counting_sort_records() returns false, leaving `out` untouched.
+void counting_sort(item_t arr[], int n);
+void parallel_counting_sort(item_t arr[], int n, int threads);
+
+// Stable counting sort of n records of `size` bytes into `out` by the item_t key at `offset`.
+bool counting_sort_records(const void* records, int n, size_t size, size_t offset, void* out);
+
+// Algorithms auto_sort() routes to, see auto_sort.c.
+enum sort_strategy
+{
+    STRATEGY_INSERTION,
+    STRATEGY_RUN_MERGE,
+    STRATEGY_COUNTING,
+    STRATEGY_RADIX,
+    STRATEGY_INTROSORT,
+    STRATEGY_COUNT
+};
+
+extern const char* const strategy_names[STRATEGY_COUNT];
+
+// Statistics of a sample of the input and the strategy they lead to.
+struct sort_profile
+{
+    int n;
+    int sample;             // sampled items
+    double run_ratio;       // sampled items not monotone with their next two neighbours, about where runs start
+    double inversion_ratio; // inverted pairs among sampled pairs, 0 sorted and 1 reversed
+    double duplicate_ratio; // sampled items equal to another sampled item
+    item_t min;             // of the sample
+    item_t max;
+    enum sort_strategy strategy;
+};
+
+void profile_input(const item_t arr[], int n, struct sort_profile* profile);
+void auto_sort(item_t arr[], int n);
+
+// Sort n C strings in strcmp order, see string_sort.c.
+void string_sort(const char* strs[], int n);
+
+// Sort the NUL-terminated strings that start at arena + offsets[i] by sorting their offsets.
+void arena_string_sort(const char* arena, uint32_t offsets[], int n);
+
+// The sorts above that need scratch memory, taking it from a workspace instead of allocating it.
+// Sorting many inputs with one workspace allocates only when an input is larger than all before.
+void merge_sort_ws(item_t arr[], int n, sort_workspace_t* ws);
+void tim_sort_ws(item_t arr[], int n, sort_workspace_t* ws);
+void radix_sort_ws(item_t arr[], int n, sort_workspace_t* ws);
+void simd_sort_ws(item_t arr[], int n, sort_workspace_t* ws);
+void counting_sort_ws(item_t arr[], int n, sort_workspace_t* ws);
+void auto_sort_ws(item_t arr[], int n, sort_workspace_t* ws);
+void string_sort_ws(const char* strs[], int n, sort_workspace_t* ws);
+void arena_string_sort_ws(const char* arena, uint32_t offsets[], int n, sort_workspace_t* ws);
+bool counting_sort_records_ws(const void* records, int n, size_t size, size_t offset, void* out,
+                              sort_workspace_t* ws);
+void sort_by_columns_ws(const void* records, int n, size_t size, const sort_column_t columns[], int count,
+                        uint32_t order[], sort_workspace_t* ws);
+
+// IEEE-754 total ordering as an unsigned key: -NaN < -inf < ... < -0.0 < +0.0 < ... < +inf < +NaN.
+static inline uint64_t f64_key(double x)
+{
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits ^ ((uint64_t)((int64_t)bits >> 63) | 0x8000000000000000ull);
+}
+
+// Typed sorts, see typed_sort.c: `*_sort` is an introsort, `*_stable_sort` a merge sort
+// `*_radix_sort` a stable LSD radix sort on the 64-bit key and `*_radix_sort_inplace` an unstable
+// in-place MSD radix sort on it. The `_ws` variants take their scratch memory from a workspace.
+void i64_sort(int64_t arr[], int n);
+void i64_stable_sort(int64_t arr[], int n);
+void i64_stable_sort_ws(int64_t arr[], int n, sort_workspace_t* ws);
+void i64_radix_sort(int64_t arr[], int n);
+void i64_radix_sort_ws(int64_t arr[], int n, sort_workspace_t* ws);
+void i64_radix_sort_inplace(int64_t arr[], int n);
+void f64_sort(double arr[], int n);
+void f64_stable_sort(double arr[], int n);
+void f64_stable_sort_ws(double arr[], int n, sort_workspace_t* ws);
+void f64_radix_sort(double arr[], int n);
+void f64_radix_sort_ws(double arr[], int n, sort_workspace_t* ws);
+void f64_radix_sort_inplace(double arr[], int n);
+void record_sort(record_t arr[], int n);
+void record_stable_sort(record_t arr[], int n);
+void record_stable_sort_ws(record_t arr[], int n, sort_workspace_t* ws);
+void record_radix_sort(record_t arr[], int n);
+void record_radix_sort_ws(record_t arr[], int n, sort_workspace_t* ws);
+void record_radix_sort_inplace(record_t arr[], int n);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif // SORT_H
@@ -0,0 +1,374 @@
+// Type-generic sorts, instantiated by defining the parameters below and including this file:
+//
+//   SORT_NAME       prefix of the generated functions, e.g. i64 gives i64_sort, i64_stable_sort, ...
+//   SORT_TYPE       element type
+//   SORT_LESS(a, b) strict weak ordering of two elements
+//   SORT_KEY(x)     optional, uint64_t whose unsigned order matches SORT_LESS, enables the radix sort
+//
+// The parameters are undefined at the end, so the file can be included again for another type.
+// No include guard on purpose.
+
+#if !defined(SORT_NAME) || !defined(SORT_TYPE) || !defined(SORT_LESS)
+#error "SORT_NAME, SORT_TYPE and SORT_LESS must be defined before including sort_template.h"
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+#define SORT_CONCAT_(a, b) a##_##b
+#define SORT_CONCAT(a, b) SORT_CONCAT_(a, b)
+#define SORT_FN(name) SORT_CONCAT(SORT_NAME, name)
+
+// Sub-arrays smaller than this are finished by insertion sort.
+#define SORT_INSERTION_THRESHOLD 24
+
+// Sub-arrays larger than this choose the pivot with Tukey's ninther instead of median-of-three.
+#define SORT_NINTHER_THRESHOLD 128
+
+static inline void SORT_FN(swap)(SORT_TYPE* a, SORT_TYPE* b)
+{
+    SORT_TYPE tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+// Stable: an element only moves past strictly greater ones.
+static inline void SORT_FN(insertion_sort)(SORT_TYPE arr[], int n)
+{
+    for (int i = 1, j; i < n; i++)
+    {
+        SORT_TYPE tmp = arr[i];
+        for (j = i; j > 0 && SORT_LESS(tmp, arr[j - 1]); j--)
+        {
+            arr[j] = arr[j - 1];
+        }
+        arr[j] = tmp;
+    }
+}
+
+static inline void SORT_FN(perc_down)(SORT_TYPE arr[], int r, int n)
+{
+    int parent, child;
+    SORT_TYPE tmp = arr[r];
+    for (parent = r; (parent * 2 + 1) < n; parent = child)
+    {
+        child = parent * 2 + 1;
+        if ((child != n - 1) && SORT_LESS(arr[child], arr[child + 1]))
+        {
+            child++;
+        }
+        if (!SORT_LESS(tmp, arr[child]))
+        {
+            break;
+        }
+        arr[parent] = arr[child];
+    }
+    arr[parent] = tmp;
+}
+
+static void SORT_FN(heap_sort)(SORT_TYPE arr[], int n)
+{
+    for (int i = n / 2 - 1; i >= 0; i--)
+    {
+        SORT_FN(perc_down)(arr, i, n);
+    }
+    for (int i = n - 1; i > 0; i--)
+    {
+        SORT_FN(swap)(&arr[0], &arr[i]);
+        SORT_FN(perc_down)(arr, 0, i);
+    }
+}
+
+static inline void SORT_FN(sort3)(SORT_TYPE* a, SORT_TYPE* b, SORT_TYPE* c)
+{
+    if (SORT_LESS(*b, *a))
+    {
+        SORT_FN(swap)(a, b);
+    }
+    if (SORT_LESS(*c, *b))
+    {
+        SORT_FN(swap)(b, c);
+    }
+    if (SORT_LESS(*b, *a))
+    {
+        SORT_FN(swap)(a, b);
+    }
+}
+
+// Introsort: recurse into the smaller side, fall back to heap sort when the depth budget runs out.
+static void SORT_FN(intro_sort)(SORT_TYPE arr[], int n, int depth)
+{
+    while (n > SORT_INSERTION_THRESHOLD)
+    {
+        if (depth-- == 0)
+        {
+            SORT_FN(heap_sort)(arr, n);
+            return;
+        }
+
+        // 枢轴放到 arr[0]，arr[n - 1] >= 枢轴作为左扫描的哨兵
+        int mid = n / 2;
+        if (n > SORT_NINTHER_THRESHOLD)
+        {
+            int s = n / 8;
+            SORT_FN(sort3)(&arr[1], &arr[1 + s], &arr[1 + 2 * s]);
+            SORT_FN(sort3)(&arr[mid - s], &arr[mid], &arr[mid + s]);
+            SORT_FN(sort3)(&arr[n - 2 - 2 * s], &arr[n - 2 - s], &arr[n - 2]);
+            SORT_FN(sort3)(&arr[1 + s], &arr[mid], &arr[n - 2 - s]);
+        }
+        SORT_FN(sort3)(&arr[0], &arr[mid], &arr[n - 1]);
+        SORT_FN(swap)(&arr[0], &arr[mid]);
+
+        // Hoare partition, stopping on equal keys keeps many-duplicates input balanced.
+        SORT_TYPE pivot = arr[0];
+        int i = 0, j = n;
+        while (true)
+        {
+            do
+            {
+                i++;
+            } while (SORT_LESS(arr[i], pivot));
+            do
+            {
+                j--;
+            } while (SORT_LESS(pivot, arr[j]));
+            if (i >= j)
+            {
+                break;
+            }
+            SORT_FN(swap)(&arr[i], &arr[j]);
+        }
+        SORT_FN(swap)(&arr[0], &arr[j]);
+
+        if (j < n - j - 1)
+        {
+            SORT_FN(intro_sort)(arr, j, depth);
+            arr += j + 1;
+            n -= j + 1;
+        }
+        else
+        {
+            SORT_FN(intro_sort)(arr + j + 1, n - j - 1, depth);
+            n = j;
+        }
+    }
+    SORT_FN(insertion_sort)(arr, n);
+}
+
+void SORT_FN(sort)(SORT_TYPE arr[], int n)
+{
+    int run = 1;
+    while (run < n && !SORT_LESS(arr[run], arr[run - 1]))
+    {
+        run++;
+    }
+    if (run >= n)
+    {
+        return;
+    }
+
+    int depth = 0;
+    for (int i = n; i > 1; i >>= 1)
+    {
+        depth += 2;
+    }
+    SORT_FN(intro_sort)(arr, n, depth);
+}
+
+// Merge sorted arr[0, mid) and arr[mid, n), the left half is copied into space.
+static inline void SORT_FN(merge)(SORT_TYPE arr[], int mid, int n, SORT_TYPE space[])
+{
+    memcpy(space, arr, mid * sizeof(SORT_TYPE));
+    int i = 0, j = mid, k = 0;
+    while (i < mid && j < n)
+    {
+        // 相等时先取左半部分，保证稳定
+        if (SORT_LESS(arr[j], space[i]))
+        {
+            arr[k++] = arr[j++];
+        }
+        else
+        {
+            arr[k++] = space[i++];
+        }
+    }
+    memcpy(arr + k, space + i, (mid - i) * sizeof(SORT_TYPE));
+}
+
+static void SORT_FN(merge_sort)(SORT_TYPE arr[], int n, SORT_TYPE space[])
+{
+    if (n <= SORT_INSERTION_THRESHOLD)
+    {
+        SORT_FN(insertion_sort)(arr, n);
+        return;
+    }
+    int mid = n / 2;
+    SORT_FN(merge_sort)(arr, mid, space);
+    SORT_FN(merge_sort)(arr + mid, n - mid, space);
+    if (SORT_LESS(arr[mid], arr[mid - 1]))
+    {
+        SORT_FN(merge)(arr, mid, n, space);
+    }
+}
+
+void SORT_FN(stable_sort_ws)(SORT_TYPE arr[], int n, sort_workspace_t* ws)
+{
+    SORT_TYPE* space = (SORT_TYPE*)sort_workspace_reserve(ws, (n / 2 + 1) * sizeof(SORT_TYPE));
+    SORT_FN(merge_sort)(arr, n, space);
+}
+
+void SORT_FN(stable_sort)(SORT_TYPE arr[], int n)
+{
+    sort_workspace_t ws;
+    sort_workspace_init(&ws, 0);
+    SORT_FN(stable_sort_ws)(arr, n, &ws);
+    sort_workspace_free(&ws);
+}
+
+#ifdef SORT_KEY
+
+// Stable LSD radix sort on the 8 bytes of SORT_KEY, skipping bytes that are equal for every element.
+void SORT_FN(radix_sort_ws)(SORT_TYPE arr[], int n, sort_workspace_t* ws)
+{
+    if (n < 64)
+    {
+        SORT_FN(insertion_sort)(arr, n);
+        return;
+    }
+
+    int count[8][256] = {{0}};
+    for (int i = 0; i < n; i++)
+    {
+        uint64_t key = SORT_KEY(arr[i]);
+        for (int pass = 0; pass < 8; pass++)
+        {
+            count[pass][(key >> (pass * 8)) & 0xFF]++;
+        }
+    }
+
+    SORT_TYPE* space = (SORT_TYPE*)sort_workspace_reserve(ws, n * sizeof(SORT_TYPE));
+
+    SORT_TYPE* src = arr;
+    SORT_TYPE* dst = space;
+    for (int pass = 0; pass < 8; pass++)
+    {
+        int shift = pass * 8;
+        if (count[pass][(SORT_KEY(src[0]) >> shift) & 0xFF] == n)
+        {
+            continue;
+        }
+
+        int sum = 0;
+        for (int digit = 0; digit < 256; digit++)
+        {
+            int c = count[pass][digit];
+            count[pass][digit] = sum;
+            sum += c;
+        }
+        for (int i = 0; i < n; i++)
+        {
+            dst[count[pass][(SORT_KEY(src[i]) >> shift) & 0xFF]++] = src[i];
+        }
+
+        SORT_TYPE* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != arr)
+    {
+        memcpy(arr, src, n * sizeof(SORT_TYPE));
+    }
+}
+
+void SORT_FN(radix_sort)(SORT_TYPE arr[], int n)
+{
+    sort_workspace_t ws;
+    sort_workspace_init(&ws, 0);
+    SORT_FN(radix_sort_ws)(arr, n, &ws);
+    sort_workspace_free(&ws);
+}
+
+// In-place American flag sort on the bytes of SORT_KEY from `shift` down, small buckets go to the introsort.
+static void SORT_FN(american_flag_sort)(SORT_TYPE arr[], int n, int shift)
+{
+    int count[256];
+    while (true)
+    {
+        if (n < 128)
+        {
+            SORT_FN(sort)(arr, n);
+            return;
+        }
+
+        memset(count, 0, sizeof(count));
+        for (int i = 0; i < n; i++)
+        {
+            count[(SORT_KEY(arr[i]) >> shift) & 0xFF]++;
+        }
+        if (count[(SORT_KEY(arr[0]) >> shift) & 0xFF] < n)
+        {
+            break;
+        }
+        if (shift == 0)
+        {
+            return;
+        }
+        shift -= 8;
+    }
+
+    int head[256], tail[256];
+    int sum = 0;
+    for (int d = 0; d < 256; d++)
+    {
+        head[d] = sum;
+        sum += count[d];
+        tail[d] = sum;
+    }
+
+    // 沿置换环把每个元素换到它的桶里
+    for (int d = 0; d < 256; d++)
+    {
+        while (head[d] < tail[d])
+        {
+            SORT_TYPE x = arr[head[d]];
+            int digit = (SORT_KEY(x) >> shift) & 0xFF;
+            while (digit != d)
+            {
+                SORT_TYPE tmp = arr[head[digit]];
+                arr[head[digit]++] = x;
+                x = tmp;
+                digit = (SORT_KEY(x) >> shift) & 0xFF;
+            }
+            arr[head[d]++] = x;
+        }
+    }
+
+    if (shift > 0)
+    {
+        for (int d = 0, begin = 0; d < 256; begin += count[d++])
+        {
+            if (count[d] > 1)
+            {
+                SORT_FN(american_flag_sort)(arr + begin, count[d], shift - 8);
+            }
+        }
+    }
+}
+
+void SORT_FN(radix_sort_inplace)(SORT_TYPE arr[], int n)
+{
+    SORT_FN(american_flag_sort)(arr, n, 56);
+}
+
+#endif // SORT_KEY
+
+#undef SORT_NINTHER_THRESHOLD
+#undef SORT_INSERTION_THRESHOLD
+#undef SORT_FN
+#undef SORT_CONCAT
+#undef SORT_CONCAT_
+#undef SORT_KEY
+#undef SORT_LESS
+#undef SORT_TYPE
+#undef SORT_NAME
@@ -0,0 +1,288 @@
+#include "sort.h"
+
+// String sort in strcmp order. Every string carries a cached 8-byte big-endian prefix of the bytes
+// from the current depth, so most comparisons are one integer compare and no shared prefix is read
+// twice. Large ranges are split by an MSD radix sort on one prefix byte at a time, which passes over
+// the bytes shared by a whole bucket, smaller ones by multikey quicksort: a three-way partition on
+// the prefix, where only the equal part moves on to the next 8 bytes.
+
+// Ranges smaller than this are finished by insertion sort.
+#define STRING_INSERTION_THRESHOLD 16
+
+// Ranges larger than this are split by the radix sort.
+#define STRING_RADIX_THRESHOLD 8192
+
+typedef struct
+{
+    uint64_t prefix; // bytes [depth, depth + 8) of str, zero after the end of the string
+    const char* str;
+} string_entry_t;
+
+struct string_sort
+{
+    string_entry_t* space;
+};
+
+// Whether the string goes on after the 8 bytes of the prefix.
+static inline bool prefix_continues(uint64_t prefix)
+{
+    return (prefix & 0xFF) != 0;
+}
+
+// The caller guarantees the string has not ended before s.
+static inline uint64_t load_prefix(const char* s)
+{
+    uint64_t key = 0;
+    for (int i = 0; i < 8 && s[i]; i++)
+    {
+        key |= (uint64_t)(uint8_t)s[i] << (56 - 8 * i);
+    }
+    return key;
+}
+
+static inline void reload(string_entry_t e[], int n, size_t depth)
+{
+    for (int i = 0; i < n; i++)
+    {
+        e[i].prefix = load_prefix(e[i].str + depth);
+    }
+}
+
+static inline int compare_entries(const string_entry_t* a, const string_entry_t* b, size_t depth)
+{
+    if (a->prefix != b->prefix)
+    {
+        return a->prefix < b->prefix ? -1 : 1;
+    }
+    return prefix_continues(a->prefix) ? strcmp(a->str + depth + 8, b->str + depth + 8) : 0;
+}
+
+static void insertion_sort_entries(string_entry_t e[], int n, size_t depth)
+{
+    for (int i = 1, j; i < n; i++)
+    {
+        string_entry_t tmp = e[i];
+        for (j = i; j > 0 && compare_entries(&tmp, &e[j - 1], depth) < 0; j--)
+        {
+            e[j] = e[j - 1];
+        }
+        e[j] = tmp;
+    }
+}
+
+static inline void swap_entries(string_entry_t* a, string_entry_t* b)
+{
+    string_entry_t tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+static inline uint64_t median3(uint64_t a, uint64_t b, uint64_t c)
+{
+    if (b < a)
+    {
+        uint64_t tmp = a;
+        a = b;
+        b = tmp;
+    }
+    return c < a ? a : c < b ? c : b;
+}
+
+static void sort_range(struct string_sort* ss, string_entry_t e[], int n, size_t depth);
+
+static void multikey_quicksort(struct string_sort* ss, string_entry_t e[], int n, size_t depth)
+{
+    while (n > STRING_INSERTION_THRESHOLD)
+    {
+        int mid = n / 2;
+        uint64_t pivot = median3(e[0].prefix, e[mid].prefix, e[n - 1].prefix);
+
+        // 三路划分：[0, lt) < pivot, [lt, gt) == pivot, [gt, n) > pivot
+        int lt = 0, i = 0, gt = n;
+        while (i < gt)
+        {
+            if (e[i].prefix < pivot)
+            {
+                swap_entries(&e[lt++], &e[i++]);
+            }
+            else if (e[i].prefix > pivot)
+            {
+                swap_entries(&e[i], &e[--gt]);
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        // 前缀相同的部分只在字符串未结束时比较后面 8 个字节
+        if (gt - lt > 1 && prefix_continues(pivot))
+        {
+            reload(e + lt, gt - lt, depth + 8);
+            sort_range(ss, e + lt, gt - lt, depth + 8);
+        }
+
+        if (lt < n - gt)
+        {
+            multikey_quicksort(ss, e, lt, depth);
+            e += gt;
+            n -= gt;
+        }
+        else
+        {
+            multikey_quicksort(ss, e + gt, n - gt, depth);
+            n = lt;
+        }
+    }
+    insertion_sort_entries(e, n, depth);
+}
+
+// Radix sort on byte b of the prefixes, which agree on their bytes before b.
+static void msd_radix_sort(struct string_sort* ss, string_entry_t e[], int n, size_t depth, int b)
+{
+    int count[256];
+    while (true)
+    {
+        int shift = 56 - 8 * b;
+        memset(count, 0, sizeof(count));
+        for (int i = 0; i < n; i++)
+        {
+            count[(e[i].prefix >> shift) & 0xFF]++;
+        }
+
+        int first = (e[0].prefix >> shift) & 0xFF;
+        if (count[first] < n)
+        {
+            break;
+        }
+        // 所有字符串在这个字节上相同：全部结束则已排好，否则直接看下一个字节
+        if (first == 0)
+        {
+            return;
+        }
+        if (++b == 8)
+        {
+            depth += 8;
+            b = 0;
+            reload(e, n, depth);
+        }
+    }
+
+    int start[257];
+    start[0] = 0;
+    for (int c = 0; c < 256; c++)
+    {
+        start[c + 1] = start[c] + count[c];
+    }
+    int next[256];
+    memcpy(next, start, sizeof(next));
+    int shift = 56 - 8 * b;
+    for (int i = 0; i < n; i++)
+    {
+        ss->space[next[(e[i].prefix >> shift) & 0xFF]++] = e[i];
+    }
+    memcpy(e, ss->space, n * sizeof(string_entry_t));
+
+    // 桶 0 中的字符串已经结束，彼此相等
+    for (int c = 1; c < 256; c++)
+    {
+        string_entry_t* bucket = e + start[c];
+        int size = count[c];
+        if (size < 2)
+        {
+            continue;
+        }
+        if (b == 7)
+        {
+            reload(bucket, size, depth + 8);
+            sort_range(ss, bucket, size, depth + 8);
+        }
+        else if (size > STRING_RADIX_THRESHOLD)
+        {
+            msd_radix_sort(ss, bucket, size, depth, b + 1);
+        }
+        else
+        {
+            multikey_quicksort(ss, bucket, size, depth);
+        }
+    }
+}
+
+static void sort_range(struct string_sort* ss, string_entry_t e[], int n, size_t depth)
+{
+    if (n > STRING_RADIX_THRESHOLD)
+    {
+        msd_radix_sort(ss, e, n, depth, 0);
+    }
+    else
+    {
+        multikey_quicksort(ss, e, n, depth);
+    }
+}
+
+// Entries in the first half of the reservation, the radix sort's scratch copy in the second.
+static string_entry_t* reserve_entries(sort_workspace_t* ws, int n)
+{
+    int copies = n > STRING_RADIX_THRESHOLD ? 2 : 1;
+    return (string_entry_t*)sort_workspace_reserve(ws, (size_t)copies * n * sizeof(string_entry_t));
+}
+
+static void sort_entries(string_entry_t e[], int n)
+{
+    struct string_sort ss;
+    ss.space = n > STRING_RADIX_THRESHOLD ? e + n : NULL;
+    reload(e, n, 0);
+    sort_range(&ss, e, n, 0);
+}
+
+void string_sort_ws(const char* strs[], int n, sort_workspace_t* ws)
+{
+    if (n < 2)
+    {
+        return;
+    }
+    string_entry_t* e = reserve_entries(ws, n);
+    for (int i = 0; i < n; i++)
+    {
+        e[i].str = strs[i];
+    }
+    sort_entries(e, n);
+    for (int i = 0; i < n; i++)
+    {
+        strs[i] = e[i].str;
+    }
+}
+
+void string_sort(const char* strs[], int n)
+{
+    sort_workspace_t ws;
+    sort_workspace_init(&ws, 0);
+    string_sort_ws(strs, n, &ws);
+    sort_workspace_free(&ws);
+}
+
+void arena_string_sort_ws(const char* arena, uint32_t offsets[], int n, sort_workspace_t* ws)
+{
+    if (n < 2)
+    {
+        return;
+    }
+    string_entry_t* e = reserve_entries(ws, n);
+    for (int i = 0; i < n; i++)
+    {
+        e[i].str = arena + offsets[i];
+    }
+    sort_entries(e, n);
+    for (int i = 0; i < n; i++)
+    {
+        offsets[i] = (uint32_t)(e[i].str - arena);
+    }
+}
+
+void arena_string_sort(const char* arena, uint32_t offsets[], int n)
+{
+    sort_workspace_t ws;
+    sort_workspace_init(&ws, 0);
+    arena_string_sort_ws(arena, offsets, n, &ws);
+    sort_workspace_free(&ws);
+}
@@ -0,0 +1,203 @@
+#include "thread_pool.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+
+#define DEQUE_INIT_CAPACITY 64
+
+// Owner pushes and pops at the bottom (LIFO, cache-warm), thieves take from the top (FIFO, biggest tasks).
+struct deque
+{
+    task_t* tasks;
+    int capacity;
+    int top;
+    int bottom;
+    pthread_mutex_t lock;
+};
+
+struct pool
+{
+    worker_t* workers;
+    int threads;
+    atomic_long pending; // tasks spawned but not finished yet
+};
+
+struct worker
+{
+    struct pool* pool;
+    struct deque deque;
+    unsigned seed;
+    pthread_t thread;
+};
+
+static void deque_push(struct deque* dq, task_t task)
+{
+    pthread_mutex_lock(&dq->lock);
+    if (dq->bottom == dq->capacity)
+    {
+        if (dq->top > 0)
+        {
+            memmove(dq->tasks, dq->tasks + dq->top, (dq->bottom - dq->top) * sizeof(task_t));
+            dq->bottom -= dq->top;
+            dq->top = 0;
+        }
+        else
+        {
+            dq->capacity *= 2;
+            dq->tasks = (task_t*)realloc(dq->tasks, dq->capacity * sizeof(task_t));
+            check_pointer(dq->tasks);
+        }
+    }
+    dq->tasks[dq->bottom++] = task;
+    pthread_mutex_unlock(&dq->lock);
+}
+
+static bool deque_pop(struct deque* dq, task_t* task)
+{
+    bool found = false;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->top < dq->bottom)
+    {
+        *task = dq->tasks[--dq->bottom];
+        found = true;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return found;
+}
+
+static bool deque_steal(struct deque* dq, task_t* task)
+{
+    bool found = false;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->top < dq->bottom)
+    {
+        *task = dq->tasks[dq->top++];
+        found = true;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return found;
+}
+
+static bool steal(worker_t* self, task_t* task)
+{
+    struct pool* pool = self->pool;
+    int start = rand_r(&self->seed) % pool->threads;
+    for (int i = 0; i < pool->threads; i++)
+    {
+        worker_t* victim = &pool->workers[(start + i) % pool->threads];
+        if (victim != self && deque_steal(&victim->deque, task))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void* work(void* arg)
+{
+    worker_t* self = (worker_t*)arg;
+    struct pool* pool = self->pool;
+    task_t task;
+
+    while (atomic_load(&pool->pending) > 0)
+    {
+        if (deque_pop(&self->deque, &task) || steal(self, &task))
+        {
+            task.run(self, task);
+            atomic_fetch_sub(&pool->pending, 1);
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+void pool_spawn(worker_t* self, task_t task)
+{
+    atomic_fetch_add(&self->pool->pending, 1);
+    deque_push(&self->deque, task);
+}
+
+void pool_run(int threads, task_t task)
+{
+    struct pool pool;
+    pool.threads = threads > 0 ? threads : 1;
+    pool.workers = (worker_t*)sort_malloc(pool.threads * sizeof(worker_t));
+    atomic_init(&pool.pending, 0);
+
+    for (int i = 0; i < pool.threads; i++)
+    {
+        worker_t* worker = &pool.workers[i];
+        worker->pool = &pool;
+        worker->seed = i * 2654435761u + 1;
+        worker->deque.capacity = DEQUE_INIT_CAPACITY;
+        worker->deque.top = worker->deque.bottom = 0;
+        worker->deque.tasks = (task_t*)sort_malloc(DEQUE_INIT_CAPACITY * sizeof(task_t));
+        pthread_mutex_init(&worker->deque.lock, NULL);
+    }
+
+    // The calling thread is worker 0 and starts with the root task.
+    pool_spawn(&pool.workers[0], task);
+    for (int i = 1; i < pool.threads; i++)
+    {
+        pthread_create(&pool.workers[i].thread, NULL, work, &pool.workers[i]);
+    }
+    work(&pool.workers[0]);
+    for (int i = 1; i < pool.threads; i++)
+    {
+        pthread_join(pool.workers[i].thread, NULL);
+    }
+
+    for (int i = 0; i < pool.threads; i++)
+    {
+        pthread_mutex_destroy(&pool.workers[i].deque.lock);
+        free(pool.workers[i].deque.tasks);
+    }
+    free(pool.workers);
+}
+
+struct loop
+{
+    void (*body)(void* context, int index);
+    void* context;
+};
+
+static void loop_task(worker_t* self, task_t task)
+{
+    const struct loop* loop = (const struct loop*)task.context;
+    loop->body(loop->context, task.n);
+}
+
+// Spawn the iterations in reverse so the owner pops them in order and thieves take the last ones.
+static void loop_root(worker_t* self, task_t task)
+{
+    for (int i = task.n - 1; i > 0; i--)
+    {
+        task_t iteration = {loop_task, NULL, i, 0, task.context};
+        pool_spawn(self, iteration);
+    }
+    task.n = 0;
+    loop_task(self, task);
+}
+
+void pool_for(int threads, int count, void (*body)(void* context, int index), void* context)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+    struct loop loop = {body, context};
+    task_t root = {loop_root, NULL, count, 0, &loop};
+    pool_run(threads, root);
+}
+
+int cpu_count(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
@@ -0,0 +1,30 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "sort.h"
+
+typedef struct worker worker_t;
+
+// A piece of work over arr[0, n), run by whichever worker pops or steals it.
+typedef struct task
+{
+    void (*run)(worker_t* self, struct task task);
+    item_t* arr;
+    int n;
+    int depth;
+    void* context;
+} task_t;
+
+// Run `task` and all the tasks it spawns on `threads` workers, return when all of them are done.
+void pool_run(int threads, task_t task);
+
+// Push a new task onto the deque of the calling worker, idle workers will steal it.
+void pool_spawn(worker_t* self, task_t task);
+
+// Call body(context, i) for every i in [0, count) on `threads` workers, return when all calls are done.
+void pool_for(int threads, int count, void (*body)(void* context, int index), void* context);
+
+// Number of online processors, at least 1.
+int cpu_count(void);
+
+#endif // THREAD_POOL_H
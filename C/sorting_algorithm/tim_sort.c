@@ -0,0 +1,565 @@
+#include "sort.h"
+
+#include <string.h>
+
+// Natural merge sort in the style of TimSort: merges existing runs, so nearly sorted input is close to linear.
+
+// Runs shorter than this are extended by binary insertion sort.
+#define MIN_MERGE 32
+
+// Initial number of consecutive wins of one run that switches a merge into galloping mode.
+#define MIN_GALLOP 7
+
+// Invariants on the run lengths keep the stack shorter than this for any int-sized array.
+#define MAX_RUNS 49
+
+struct run
+{
+    int base;
+    int len;
+};
+
+struct tim_state
+{
+    item_t* arr;
+    item_t* tmp; // holds the shorter run during a merge, at most n / 2 elements
+    int min_gallop;
+    struct run stack[MAX_RUNS];
+    int size;
+};
+
+// Length of the shortest run, so that n / min_run is a power of two or slightly less.
+static inline int min_run_length(int n)
+{
+    int r = 0;
+    while (n >= MIN_MERGE)
+    {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
+
+// Length of the run starting at arr[lo], a strictly descending run is reversed in place.
+// Only strict descents are reversed, so equal elements never change their relative order.
+static inline int count_run(item_t arr[], int lo, int hi)
+{
+    int run_hi = lo + 1;
+    if (run_hi == hi)
+    {
+        return 1;
+    }
+
+    if (arr[run_hi++] < arr[lo])
+    {
+        while (run_hi < hi && arr[run_hi] < arr[run_hi - 1])
+        {
+            run_hi++;
+        }
+        for (int i = lo, j = run_hi - 1; i < j; i++, j--)
+        {
+            swap(&arr[i], &arr[j]);
+        }
+    }
+    else
+    {
+        while (run_hi < hi && !(arr[run_hi] < arr[run_hi - 1]))
+        {
+            run_hi++;
+        }
+    }
+    return run_hi - lo;
+}
+
+// Sort arr[lo, hi) where arr[lo, start) is already sorted.
+static inline void binary_insertion_sort(item_t arr[], int lo, int hi, int start)
+{
+    for (; start < hi; start++)
+    {
+        item_t pivot = arr[start];
+        int left = lo, right = start;
+        while (left < right)
+        {
+            int mid = (left + right) >> 1;
+            if (pivot < arr[mid])
+            {
+                right = mid;
+            }
+            else
+            {
+                left = mid + 1;
+            }
+        }
+        memmove(&arr[left + 1], &arr[left], (start - left) * sizeof(item_t));
+        arr[left] = pivot;
+    }
+}
+
+// Leftmost position to insert key into sorted arr[0, len), searching outwards from arr[hint].
+static int gallop_left(item_t key, const item_t arr[], int len, int hint)
+{
+    int last_ofs = 0, ofs = 1;
+    if (arr[hint] < key)
+    {
+        int max_ofs = len - hint;
+        while (ofs < max_ofs && arr[hint + ofs] < key)
+        {
+            last_ofs = ofs;
+            ofs = (ofs << 1) + 1;
+            if (ofs <= 0)
+            {
+                ofs = max_ofs;
+            }
+        }
+        if (ofs > max_ofs)
+        {
+            ofs = max_ofs;
+        }
+        last_ofs += hint;
+        ofs += hint;
+    }
+    else
+    {
+        int max_ofs = hint + 1;
+        while (ofs < max_ofs && !(arr[hint - ofs] < key))
+        {
+            last_ofs = ofs;
+            ofs = (ofs << 1) + 1;
+            if (ofs <= 0)
+            {
+                ofs = max_ofs;
+            }
+        }
+        if (ofs > max_ofs)
+        {
+            ofs = max_ofs;
+        }
+        int tmp = last_ofs;
+        last_ofs = hint - ofs;
+        ofs = hint - tmp;
+    }
+
+    // arr[last_ofs] < key <= arr[ofs], binary search in between
+    last_ofs++;
+    while (last_ofs < ofs)
+    {
+        int mid = last_ofs + ((ofs - last_ofs) >> 1);
+        if (arr[mid] < key)
+        {
+            last_ofs = mid + 1;
+        }
+        else
+        {
+            ofs = mid;
+        }
+    }
+    return ofs;
+}
+
+// Rightmost position to insert key into sorted arr[0, len), searching outwards from arr[hint].
+static int gallop_right(item_t key, const item_t arr[], int len, int hint)
+{
+    int last_ofs = 0, ofs = 1;
+    if (key < arr[hint])
+    {
+        int max_ofs = hint + 1;
+        while (ofs < max_ofs && key < arr[hint - ofs])
+        {
+            last_ofs = ofs;
+            ofs = (ofs << 1) + 1;
+            if (ofs <= 0)
+            {
+                ofs = max_ofs;
+            }
+        }
+        if (ofs > max_ofs)
+        {
+            ofs = max_ofs;
+        }
+        int tmp = last_ofs;
+        last_ofs = hint - ofs;
+        ofs = hint - tmp;
+    }
+    else
+    {
+        int max_ofs = len - hint;
+        while (ofs < max_ofs && !(key < arr[hint + ofs]))
+        {
+            last_ofs = ofs;
+            ofs = (ofs << 1) + 1;
+            if (ofs <= 0)
+            {
+                ofs = max_ofs;
+            }
+        }
+        if (ofs > max_ofs)
+        {
+            ofs = max_ofs;
+        }
+        last_ofs += hint;
+        ofs += hint;
+    }
+
+    // arr[last_ofs] <= key < arr[ofs], binary search in between
+    last_ofs++;
+    while (last_ofs < ofs)
+    {
+        int mid = last_ofs + ((ofs - last_ofs) >> 1);
+        if (key < arr[mid])
+        {
+            ofs = mid;
+        }
+        else
+        {
+            last_ofs = mid + 1;
+        }
+    }
+    return ofs;
+}
+
+// Merge adjacent runs where len1 <= len2, copying the first run into tmp and filling from the left.
+static void merge_lo(struct tim_state* ts, int base1, int len1, int base2, int len2)
+{
+    item_t* a = ts->arr;
+    item_t* tmp = ts->tmp;
+    memcpy(tmp, a + base1, len1 * sizeof(item_t));
+
+    int cursor1 = 0, cursor2 = base2, dest = base1;
+    int min_gallop = ts->min_gallop;
+
+    // 第二段的首元素小于第一段全部元素（已由 gallop_right 保证）
+    a[dest++] = a[cursor2++];
+    if (--len2 == 0)
+    {
+        goto done;
+    }
+    if (len1 == 1)
+    {
+        goto done;
+    }
+
+    while (true)
+    {
+        int count1 = 0, count2 = 0;
+
+        // 逐个比较，直到某一段连续胜出 min_gallop 次
+        do
+        {
+            if (a[cursor2] < tmp[cursor1])
+            {
+                a[dest++] = a[cursor2++];
+                count2++;
+                count1 = 0;
+                if (--len2 == 0)
+                {
+                    goto done;
+                }
+            }
+            else
+            {
+                a[dest++] = tmp[cursor1++];
+                count1++;
+                count2 = 0;
+                if (--len1 == 1)
+                {
+                    goto done;
+                }
+            }
+        } while ((count1 | count2) < min_gallop);
+
+        // 飞奔模式：用指数搜索一次搬运一整段
+        do
+        {
+            count1 = gallop_right(a[cursor2], tmp + cursor1, len1, 0);
+            if (count1 != 0)
+            {
+                memcpy(a + dest, tmp + cursor1, count1 * sizeof(item_t));
+                dest += count1;
+                cursor1 += count1;
+                len1 -= count1;
+                if (len1 <= 1)
+                {
+                    goto done;
+                }
+            }
+            a[dest++] = a[cursor2++];
+            if (--len2 == 0)
+            {
+                goto done;
+            }
+
+            count2 = gallop_left(tmp[cursor1], a + cursor2, len2, 0);
+            if (count2 != 0)
+            {
+                memmove(a + dest, a + cursor2, count2 * sizeof(item_t));
+                dest += count2;
+                cursor2 += count2;
+                len2 -= count2;
+                if (len2 == 0)
+                {
+                    goto done;
+                }
+            }
+            a[dest++] = tmp[cursor1++];
+            if (--len1 == 1)
+            {
+                goto done;
+            }
+            min_gallop--;
+        } while (count1 >= MIN_GALLOP || count2 >= MIN_GALLOP);
+
+        if (min_gallop < 0)
+        {
+            min_gallop = 0;
+        }
+        min_gallop += 2; // 离开飞奔模式的惩罚
+    }
+
+done:
+    ts->min_gallop = min_gallop < 1 ? 1 : min_gallop;
+    if (len1 == 1)
+    {
+        // 第一段只剩一个元素，它大于第二段剩余的所有元素
+        memmove(a + dest, a + cursor2, len2 * sizeof(item_t));
+        a[dest + len2] = tmp[cursor1];
+    }
+    else
+    {
+        memcpy(a + dest, tmp + cursor1, len1 * sizeof(item_t));
+    }
+}
+
+// Merge adjacent runs where len1 > len2, copying the second run into tmp and filling from the right.
+static void merge_hi(struct tim_state* ts, int base1, int len1, int base2, int len2)
+{
+    item_t* a = ts->arr;
+    item_t* tmp = ts->tmp;
+    memcpy(tmp, a + base2, len2 * sizeof(item_t));
+
+    int cursor1 = base1 + len1 - 1, cursor2 = len2 - 1, dest = base2 + len2 - 1;
+    int min_gallop = ts->min_gallop;
+
+    // 第一段的末元素大于第二段全部元素（已由 gallop_left 保证）
+    a[dest--] = a[cursor1--];
+    if (--len1 == 0)
+    {
+        goto done;
+    }
+    if (len2 == 1)
+    {
+        goto done;
+    }
+
+    while (true)
+    {
+        int count1 = 0, count2 = 0;
+
+        do
+        {
+            if (tmp[cursor2] < a[cursor1])
+            {
+                a[dest--] = a[cursor1--];
+                count1++;
+                count2 = 0;
+                if (--len1 == 0)
+                {
+                    goto done;
+                }
+            }
+            else
+            {
+                a[dest--] = tmp[cursor2--];
+                count2++;
+                count1 = 0;
+                if (--len2 == 1)
+                {
+                    goto done;
+                }
+            }
+        } while ((count1 | count2) < min_gallop);
+
+        do
+        {
+            count1 = len1 - gallop_right(tmp[cursor2], a + base1, len1, len1 - 1);
+            if (count1 != 0)
+            {
+                dest -= count1;
+                cursor1 -= count1;
+                len1 -= count1;
+                memmove(a + dest + 1, a + cursor1 + 1, count1 * sizeof(item_t));
+                if (len1 == 0)
+                {
+                    goto done;
+                }
+            }
+            a[dest--] = tmp[cursor2--];
+            if (--len2 == 1)
+            {
+                goto done;
+            }
+
+            count2 = len2 - gallop_left(a[cursor1], tmp, len2, len2 - 1);
+            if (count2 != 0)
+            {
+                dest -= count2;
+                cursor2 -= count2;
+                len2 -= count2;
+                memcpy(a + dest + 1, tmp + cursor2 + 1, count2 * sizeof(item_t));
+                if (len2 <= 1)
+                {
+                    goto done;
+                }
+            }
+            a[dest--] = a[cursor1--];
+            if (--len1 == 0)
+            {
+                goto done;
+            }
+            min_gallop--;
+        } while (count1 >= MIN_GALLOP || count2 >= MIN_GALLOP);
+
+        if (min_gallop < 0)
+        {
+            min_gallop = 0;
+        }
+        min_gallop += 2;
+    }
+
+done:
+    ts->min_gallop = min_gallop < 1 ? 1 : min_gallop;
+    if (len2 == 1)
+    {
+        // 第二段只剩一个元素，它小于第一段剩余的所有元素
+        dest -= len1;
+        cursor1 -= len1;
+        memmove(a + dest + 1, a + cursor1 + 1, len1 * sizeof(item_t));
+        a[dest] = tmp[cursor2];
+    }
+    else
+    {
+        memcpy(a + dest - (len2 - 1), tmp, len2 * sizeof(item_t));
+    }
+}
+
+// Merge the runs at stack[i] and stack[i + 1].
+static void merge_at(struct tim_state* ts, int i)
+{
+    int base1 = ts->stack[i].base, len1 = ts->stack[i].len;
+    int base2 = ts->stack[i + 1].base, len2 = ts->stack[i + 1].len;
+
+    ts->stack[i].len = len1 + len2;
+    if (i == ts->size - 3)
+    {
+        ts->stack[i + 1] = ts->stack[i + 2];
+    }
+    ts->size--;
+
+    // 跳过第一段中已经就位的前缀和第二段中已经就位的后缀
+    int k = gallop_right(ts->arr[base2], ts->arr + base1, len1, 0);
+    base1 += k;
+    len1 -= k;
+    if (len1 == 0)
+    {
+        return;
+    }
+    len2 = gallop_left(ts->arr[base1 + len1 - 1], ts->arr + base2, len2, len2 - 1);
+    if (len2 == 0)
+    {
+        return;
+    }
+
+    if (len1 <= len2)
+    {
+        merge_lo(ts, base1, len1, base2, len2);
+    }
+    else
+    {
+        merge_hi(ts, base1, len1, base2, len2);
+    }
+}
+
+// Merge until the run lengths on the stack satisfy, for the top runs X, Y, Z, W (Z on top):
+// W > X + Y, X > Y + Z and Y > Z, which keeps merges balanced and the stack logarithmic.
+static void merge_collapse(struct tim_state* ts)
+{
+    struct run* s = ts->stack;
+    while (ts->size > 1)
+    {
+        int n = ts->size - 2;
+        if ((n > 0 && s[n - 1].len <= s[n].len + s[n + 1].len) || (n > 1 && s[n - 2].len <= s[n - 1].len + s[n].len))
+        {
+            if (s[n - 1].len < s[n + 1].len)
+            {
+                n--;
+            }
+        }
+        else if (s[n].len > s[n + 1].len)
+        {
+            break;
+        }
+        merge_at(ts, n);
+    }
+}
+
+static void merge_force_collapse(struct tim_state* ts)
+{
+    struct run* s = ts->stack;
+    while (ts->size > 1)
+    {
+        int n = ts->size - 2;
+        if (n > 0 && s[n - 1].len < s[n + 1].len)
+        {
+            n--;
+        }
+        merge_at(ts, n);
+    }
+}
+
+void tim_sort_ws(item_t arr[], int n, sort_workspace_t* ws)
+{
+    if (n < 2)
+    {
+        return;
+    }
+    if (n < MIN_MERGE)
+    {
+        binary_insertion_sort(arr, 0, n, count_run(arr, 0, n));
+        return;
+    }
+
+    struct tim_state ts;
+    ts.arr = arr;
+    ts.tmp = (item_t*)sort_workspace_reserve(ws, (n / 2 + 1) * sizeof(item_t));
+    ts.min_gallop = MIN_GALLOP;
+    ts.size = 0;
+
+    int min_run = min_run_length(n);
+    for (int lo = 0; lo < n;)
+    {
+        int len = count_run(arr, lo, n);
+
+        // 过短的自然有序段用二分插入排序扩展到 min_run
+        if (len < min_run)
+        {
+            int force = n - lo < min_run ? n - lo : min_run;
+            binary_insertion_sort(arr, lo, lo + force, lo + len);
+            len = force;
+        }
+
+        ts.stack[ts.size].base = lo;
+        ts.stack[ts.size].len = len;
+        ts.size++;
+        merge_collapse(&ts);
+
+        lo += len;
+    }
+    merge_force_collapse(&ts);
+}
+
+void tim_sort(item_t arr[], int n)
+{
+    sort_workspace_t ws;
+    sort_workspace_init(&ws, 0);
+    tim_sort_ws(arr, n, &ws);
+    sort_workspace_free(&ws);
+}
@@ -0,0 +1,26 @@
+#include "sort.h"
+
+// Sorts for the production key types, instantiated from sort_template.h.
+
+static inline uint64_t i64_key(int64_t x)
+{
+    return (uint64_t)x ^ 0x8000000000000000ull;
+}
+
+#define SORT_NAME i64
+#define SORT_TYPE int64_t
+#define SORT_LESS(a, b) ((a) < (b))
+#define SORT_KEY(x) i64_key(x)
+#include "sort_template.h"
+
+#define SORT_NAME f64
+#define SORT_TYPE double
+#define SORT_LESS(a, b) (f64_key(a) < f64_key(b))
+#define SORT_KEY(x) f64_key(x)
+#include "sort_template.h"
+
+#define SORT_NAME record
+#define SORT_TYPE record_t
+#define SORT_LESS(a, b) ((a).key < (b).key)
+#define SORT_KEY(x) ((x).key)
+#include "sort_template.h"
@@ -0,0 +1,10 @@
+set_languages("gnu11", "cxx20")
+
+add_rules("mode.debug", "mode.release")
+
+-- B+tree of btree.c against std::multiset, with the sorts it uses but without the benchmark's main()
+target("btree_bench")
+    set_kind("binary")
+    add_files("*.c|main.c", "btree_bench.cpp")
+    add_vectorexts("avx2")
+    add_syslinks("pthread", "m")